@@ -0,0 +1,86 @@
+/*
+ * Copyright 2022 PixlOne
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <ipcgull/call_context.h>
+#include <ipcgull/exception.h>
+
+using namespace ipcgull;
+
+namespace {
+    thread_local const call_context* current_context = nullptr;
+}
+
+cancellation_token::cancellation_token() :
+        _deadline(clock::time_point::max()) {
+}
+
+cancellation_token::cancellation_token(
+        std::shared_ptr<const std::atomic_bool> flag,
+        clock::time_point deadline) :
+        _flag(std::move(flag)), _deadline(deadline) {
+}
+
+bool cancellation_token::cancelled() const {
+    if (_flag && *_flag)
+        return true;
+    if (_deadline == clock::time_point::max())
+        return false;
+    return clock::now() >= _deadline;
+}
+
+void cancellation_token::throw_if_cancelled() const {
+    if (cancelled())
+        throw call_cancelled();
+}
+
+cancellation_token::clock::time_point cancellation_token::deadline() const {
+    return _deadline;
+}
+
+call_context::call_context(std::string sender, cancellation_token token) :
+        _sender(std::move(sender)), _token(std::move(token)) {
+}
+
+const std::string& call_context::sender() const {
+    return _sender;
+}
+
+const cancellation_token& call_context::token() const {
+    return _token;
+}
+
+cancellation_token::clock::time_point call_context::deadline() const {
+    return _token.deadline();
+}
+
+bool call_context::cancelled() const {
+    return _token.cancelled();
+}
+
+const call_context* call_context::current() {
+    return current_context;
+}
+
+call_context::scope::scope(const call_context& context) :
+        _previous(current_context) {
+    current_context = &context;
+}
+
+call_context::scope::~scope() {
+    current_context = _previous;
+}
@@ -44,3 +44,13 @@ permission_denied::permission_denied() :
 const char* permission_denied::what() const noexcept {
     return _what.c_str();
 }
+
+call_cancelled::call_cancelled(std::string w) :
+        _what(std::move(w)) {}
+
+call_cancelled::call_cancelled() :
+        call_cancelled("Call cancelled") {}
+
+const char* call_cancelled::what() const noexcept {
+    return _what.c_str();
+}
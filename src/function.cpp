@@ -21,10 +21,79 @@
 
 using namespace ipcgull;
 
+_invoker::_invoker(const _invoker& o) : _call(o._call), _manage(o._manage) {
+    if (_manage)
+        _manage(copy_op, _storage, const_cast<storage*>(&o._storage));
+}
+
+_invoker::_invoker(_invoker&& o) noexcept: _call(o._call),
+                                           _manage(o._manage) {
+    if (_manage)
+        _manage(move_op, _storage, &o._storage);
+    o._call = nullptr;
+    o._manage = nullptr;
+}
+
+_invoker::~_invoker() {
+    _reset();
+}
+
+_invoker& _invoker::operator=(const _invoker& o) {
+    if (this != &o) {
+        _invoker copy(o);
+        *this = std::move(copy);
+    }
+
+    return *this;
+}
+
+_invoker& _invoker::operator=(_invoker&& o) noexcept {
+    if (this != &o) {
+        _reset();
+        _call = o._call;
+        _manage = o._manage;
+        if (_manage)
+            _manage(move_op, _storage, &o._storage);
+        o._call = nullptr;
+        o._manage = nullptr;
+    }
+
+    return *this;
+}
+
+void _invoker::_reset() noexcept {
+    if (_manage)
+        _manage(destroy_op, _storage, nullptr);
+    _call = nullptr;
+    _manage = nullptr;
+}
+
 variant_tuple function::operator()(const variant_tuple& args) const {
+    return _f(args).value();
+}
+
+result<variant_tuple> function::invoke(const variant_tuple& args) const {
     return _f(args);
 }
 
+function& function::set_timeout(std::chrono::milliseconds timeout) {
+    _timeout = timeout;
+    return *this;
+}
+
+std::chrono::milliseconds function::timeout() const {
+    return _timeout;
+}
+
+function& function::set_cancel_on_disconnect(bool cancel) {
+    _cancel_on_disconnect = cancel;
+    return *this;
+}
+
+bool function::cancel_on_disconnect() const {
+    return _cancel_on_disconnect;
+}
+
 const std::vector<std::string>& function::arg_names() const {
     return _arg_names;
 }
@@ -0,0 +1,86 @@
+/*
+ * Copyright 2022 PixlOne
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef IPCGULL_CALL_CONTEXT_H
+#define IPCGULL_CALL_CONTEXT_H
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+
+namespace ipcgull {
+    // Fires once the deadline passes or the flag is raised by the backend
+    // (e.g. the caller disconnected, see
+    // function::set_cancel_on_disconnect). Cheap to copy, may be handed to
+    // worker threads.
+    class cancellation_token {
+    public:
+        typedef std::chrono::steady_clock clock;
+    private:
+        std::shared_ptr<const std::atomic_bool> _flag;
+        clock::time_point _deadline;
+    public:
+        // A default constructed token never fires
+        cancellation_token();
+
+        cancellation_token(std::shared_ptr<const std::atomic_bool> flag,
+                           clock::time_point deadline);
+
+        [[nodiscard]] bool cancelled() const;
+
+        // Throws call_cancelled if the token has fired
+        void throw_if_cancelled() const;
+
+        [[nodiscard]] clock::time_point deadline() const;
+    };
+
+    class call_context {
+        const std::string _sender;
+        const cancellation_token _token;
+    public:
+        call_context(std::string sender, cancellation_token token);
+
+        call_context(const call_context&) = delete;
+
+        [[nodiscard]] const std::string& sender() const;
+
+        [[nodiscard]] const cancellation_token& token() const;
+
+        [[nodiscard]] cancellation_token::clock::time_point deadline() const;
+
+        [[nodiscard]] bool cancelled() const;
+
+        // The context of the call being handled on this thread, or nullptr
+        // when not inside a handler.
+        [[nodiscard]] static const call_context* current();
+
+        // Installed by the backend for the duration of a handler
+        class scope {
+            const call_context* const _previous;
+        public:
+            explicit scope(const call_context& context);
+
+            ~scope();
+
+            scope(const scope&) = delete;
+        };
+    };
+}
+
+#endif //IPCGULL_CALL_CONTEXT_H
@@ -52,6 +52,17 @@ namespace ipcgull {
 
         [[nodiscard]] const char* what() const noexcept override;
     };
+
+    class call_cancelled : public std::exception {
+    private:
+        const std::string _what;
+    public:
+        explicit call_cancelled(std::string w);
+
+        call_cancelled();
+
+        [[nodiscard]] const char* what() const noexcept override;
+    };
 }
 
 #endif //IPCGULL_EXCEPTION_H
@@ -19,8 +19,12 @@
 #ifndef IPCGULL_FUNCTION_H
 #define IPCGULL_FUNCTION_H
 
+#include <array>
 #include <cassert>
+#include <chrono>
+#include <cstddef>
 #include <functional>
+#include <new>
 #include <ipcgull/variant.h>
 
 namespace ipcgull {
@@ -32,101 +36,250 @@ namespace ipcgull {
     struct is_specialization<Base<Args...>, Base> : std::true_type {
     };
 
-    template<typename R, typename... Args>
-    struct _fn_generator {
-        [[maybe_unused]]
-        static std::function<variant_tuple(variant_tuple)> make_fn(
-                std::function<R(Args...)> f) {
-            return [func = std::move(f)]
-                    (const variant_tuple& args) -> variant_tuple {
-                std::vector<variant> ret{to_variant(
-                        std::apply(func,
-                                   from_variant<std::tuple<Args...>>(
-                                           args)))};
-                return ret;
-            };
+    // Wraps a handler's return value into the reply tuple
+    template<typename R>
+    struct _fn_return {
+        static constexpr std::size_t size = 1;
+
+        static std::vector<variant_type> types() {
+            return {make_variant_type<R>()};
         }
-    };
 
-    template<typename R>
-    struct _fn_generator<R> {
-        [[maybe_unused]]
-        static std::function<variant_tuple(variant_tuple)> make_fn(
-                std::function<R()> f) {
-            return [func = std::move(f)]
-                    (const variant_tuple& args) -> variant_tuple {
-                if (!args.empty())
-                    throw std::bad_variant_access();
-                std::vector<variant> ret{to_variant(func())};
-                return ret;
-            };
+        static result<variant_tuple> make(const R& r) {
+            return variant_tuple(std::vector<variant>{to_variant(r)});
         }
     };
 
-    template<typename... R, typename... Args>
-    struct _fn_generator<std::tuple<R...>, Args...> {
-        [[maybe_unused]]
-        static std::function<variant_tuple(variant_tuple)> make_fn(
-                std::function<std::tuple<R...>(Args...)> f) {
-            return [func = std::move(f)]
-                    (const variant_tuple& args) -> variant_tuple {
-                auto ret = to_variant(std::apply(
-                        func, from_variant<std::tuple<Args...>>(args)));
-                assert(std::holds_alternative<variant_tuple>(ret));
-                return std::get<variant_tuple>(ret);
-            };
+    template<>
+    struct _fn_return<void> {
+        static constexpr std::size_t size = 0;
+
+        static std::vector<variant_type> types() {
+            return {};
         }
     };
 
     template<typename... R>
-    struct _fn_generator<std::tuple<R...>> {
-        [[maybe_unused]]
-        static std::function<variant_tuple(variant_tuple)> make_fn(
-                std::function<std::tuple<R...>()> f) {
-            return [func = std::move(f)](const variant_tuple& args) {
-                if (!args.empty())
-                    throw std::bad_variant_access();
-                auto ret = to_variant(func());
-                assert(std::holds_alternative<variant_tuple>(ret));
-                return std::get<variant_tuple>(ret);
-            };
+    struct _fn_return<std::tuple<R...>> {
+        static constexpr std::size_t size = sizeof...(R);
+
+        static std::vector<variant_type> types() {
+            return {make_variant_type<R>()...};
+        }
+
+        static result<variant_tuple> make(const std::tuple<R...>& r) {
+            auto ret = to_variant(r);
+            assert(std::holds_alternative<variant_tuple>(ret));
+            return std::move(std::get<variant_tuple>(ret));
         }
     };
 
-    template<typename... Args>
-    struct _fn_generator<void, Args...> {
-        [[maybe_unused]]
-        static std::function<variant_tuple(variant_tuple)> make_fn(
-                std::function<void(Args...)> f) {
-            return [func = std::move(f)]
-                    (const variant_tuple& args) -> variant_tuple {
-                std::apply(func, from_variant<std::tuple<Args...>>(args));
-                return {};
-            };
+    template<typename R>
+    struct _fn_return<result<R>> {
+        static constexpr std::size_t size = _fn_return<R>::size;
+
+        static std::vector<variant_type> types() {
+            return _fn_return<R>::types();
+        }
+
+        static result<variant_tuple> make(const result<R>& r) {
+            if (!r)
+                return r.error();
+            return _fn_return<R>::make(*r);
         }
     };
 
     template<>
-    struct _fn_generator<void> {
-        static std::function<variant_tuple(variant_tuple)> make_fn(
-                std::function<void()> f) {
-            return [func = std::move(f)]
-                    (const variant_tuple& args) -> variant_tuple {
-                if (!args.empty())
-                    throw std::bad_variant_access();
-                func();
-                return {};
-            };
+    struct _fn_return<result<void>> {
+        static constexpr std::size_t size = 0;
+
+        static std::vector<variant_type> types() {
+            return {};
+        }
+
+        static result<variant_tuple> make(const result<void>& r) {
+            if (!r)
+                return r.error();
+            return variant_tuple();
+        }
+    };
+
+    // Bound member function, called without going through std::function
+    template<typename T, typename F>
+    struct _member_call {
+        T* t;
+        F f;
+
+        template<typename... Args>
+        decltype(auto) operator()(Args&& ... args) const {
+            return (t->*f)(std::forward<Args>(args)...);
+        }
+    };
+
+    // Type-erased handler: decodes the arguments, calls the target and
+    // encodes the reply behind a single indirect call. Object plus member
+    // pointers, function pointers and std::functions are stored inline.
+    class _invoker {
+    public:
+        static constexpr std::size_t buffer_size = 4 * sizeof(void*);
+    private:
+        union storage {
+            void* heap;
+            alignas(std::max_align_t) unsigned char buffer[buffer_size];
+        };
+
+        enum manage_op {
+            copy_op,
+            move_op,
+            destroy_op
+        };
+
+        typedef result<variant_tuple> (* call_fn)(const storage&,
+                                                  const variant_tuple&);
+        // copy_op and move_op construct `self` from `other`, move_op also
+        // destroys `other`. destroy_op ignores `other`.
+        typedef void (* manage_fn)(manage_op, storage& self, storage* other);
+
+        call_fn _call = nullptr;
+        manage_fn _manage = nullptr;
+        storage _storage{};
+
+        template<typename F>
+        static constexpr bool _stored_inline =
+                sizeof(F) <= buffer_size &&
+                alignof(F) <= alignof(std::max_align_t) &&
+                std::is_nothrow_move_constructible<F>::value;
+
+        template<typename F>
+        static F& _target(storage& s) {
+            if constexpr (_stored_inline<F>)
+                return *std::launder(reinterpret_cast<F*>(s.buffer));
+            else
+                return *static_cast<F*>(s.heap);
         }
+
+        template<typename F>
+        static const F& _target(const storage& s) {
+            return _target<F>(const_cast<storage&>(s));
+        }
+
+        template<typename F>
+        static void _manage_impl(manage_op op, storage& self,
+                                 storage* other) {
+            if constexpr (_stored_inline<F>) {
+                switch (op) {
+                    case copy_op:
+                        new(self.buffer) F(_target<F>(*other));
+                        break;
+                    case move_op:
+                        new(self.buffer) F(std::move(_target<F>(*other)));
+                        _target<F>(*other).~F();
+                        break;
+                    case destroy_op:
+                        _target<F>(self).~F();
+                        break;
+                }
+            } else {
+                switch (op) {
+                    case copy_op:
+                        self.heap = new F(_target<F>(*other));
+                        break;
+                    case move_op:
+                        self.heap = other->heap;
+                        other->heap = nullptr;
+                        break;
+                    case destroy_op:
+                        delete &_target<F>(self);
+                        break;
+                }
+            }
+        }
+
+        template<typename F, typename R, typename... Args>
+        static result<variant_tuple> _call_impl(const storage& s,
+                                                const variant_tuple& args) {
+            typedef typename _normalize_type<
+                    std::tuple<Args...>>::type arg_tuple;
+            arg_tuple decoded;
+            if (!_variant_helper<arg_tuple>::try_get(args, decoded))
+                return call_error(error_invalid_signature,
+                                  "Invalid argument type");
+
+            const F& f = _target<F>(s);
+            if constexpr (std::is_void<R>::value) {
+                std::apply(f, std::move(decoded));
+                return variant_tuple();
+            } else {
+                return _fn_return<R>::make(
+                        std::apply(f, std::move(decoded)));
+            }
+        }
+
+        _invoker() = default;
+
+        void _reset() noexcept;
+
+    public:
+        // f must be callable as R(Args...)
+        template<typename R, typename... Args, typename F>
+        static _invoker make(F f) {
+            _invoker ret;
+            if constexpr (_stored_inline<F>)
+                new(ret._storage.buffer) F(std::move(f));
+            else
+                ret._storage.heap = new F(std::move(f));
+            ret._call = &_call_impl<F, R, Args...>;
+            ret._manage = &_manage_impl<F>;
+            return ret;
+        }
+
+        _invoker(const _invoker& o);
+
+        _invoker(_invoker&& o) noexcept;
+
+        ~_invoker();
+
+        _invoker& operator=(const _invoker& o);
+
+        _invoker& operator=(_invoker&& o) noexcept;
+
+        result<variant_tuple> operator()(const variant_tuple& args) const {
+            return _call(_storage, args);
+        }
+    };
+
+    template<typename R, typename... Args>
+    struct _signature {
     };
 
     class function {
+    public:
+        // No deadline: callers choose their own reply timeouts
+        static constexpr std::chrono::milliseconds default_timeout{0};
     private:
-        std::function<variant_tuple(const variant_tuple&)> _f;
+        _invoker _f;
         std::vector<std::string> _arg_names;
         std::vector<variant_type> _arg_types;
         std::vector<std::string> _return_names;
         std::vector<variant_type> _return_types;
+        std::chrono::milliseconds _timeout = default_timeout;
+        bool _cancel_on_disconnect = false;
+
+        typedef std::array<std::string, 0> _no_names;
+
+        template<typename R, typename... Args, typename F, std::size_t N>
+        function(_signature<R, Args...>, F f,
+                 const std::array<std::string, sizeof...(Args)>& arg_names,
+                 const std::array<std::string, N>& return_names) :
+                _f(_invoker::make<R, Args...>(std::move(f))),
+                _arg_names(arg_names.begin(), arg_names.end()),
+                _arg_types({make_variant_type<Args>()...}),
+                _return_names(return_names.begin(), return_names.end()),
+                _return_types(_fn_return<R>::types()) {
+            static_assert(N == _fn_return<R>::size,
+                          "Return name count does not match the return type");
+        }
+
     public:
         function() = delete;
 
@@ -134,18 +287,15 @@ namespace ipcgull {
         function(const std::function<std::tuple<R...>(Args...)>& f,
                  const std::array<std::string, sizeof...(Args)>& arg_names,
                  const std::array<std::string, sizeof...(R)>& return_names) :
-                _f(_fn_generator<std::tuple<R...>, Args...>::make_fn(f)),
-                _arg_names(arg_names.begin(), arg_names.end()),
-                _arg_types({make_variant_type<Args>()...}),
-                _return_names(return_names.begin(), return_names.end()),
-                _return_types({make_variant_type<R>()...}) {
+                function(_signature<std::tuple<R...>, Args...>(), f,
+                         arg_names, return_names) {
         }
 
         template<typename... R, typename... Args>
         function(std::tuple<R...>(* f)(Args...),
                  const std::array<std::string, sizeof...(Args)>& arg_names,
                  const std::array<std::string, sizeof...(R)>& return_names) :
-                function(std::function<std::tuple<R...>(Args...)>(f),
+                function(_signature<std::tuple<R...>, Args...>(), f,
                          arg_names, return_names) {
         }
 
@@ -153,10 +303,8 @@ namespace ipcgull {
         function(T* t, std::tuple<R...>(T::*f)(Args...),
                  const std::array<std::string, sizeof...(Args)>& arg_names,
                  const std::array<std::string, sizeof...(R)>& return_names) :
-                function(std::function<std::tuple<R...>(Args...)>(
-                                 [t, f](Args... args) -> std::tuple<R...> {
-                                     return (t->*f)(args...);
-                                 }),
+                function(_signature<std::tuple<R...>, Args...>(),
+                         _member_call<T, decltype(f)>{t, f},
                          arg_names, return_names) {
         }
 
@@ -164,10 +312,8 @@ namespace ipcgull {
         function(T* t, std::tuple<R...>(T::*f)(Args...) const,
                  const std::array<std::string, sizeof...(Args)>& arg_names,
                  const std::array<std::string, sizeof...(R)>& return_names) :
-                function(std::function<std::tuple<R...>(Args...)>(
-                                 [t, f](Args... args) -> std::tuple<R...> {
-                                     return (t->*f)(args...);
-                                 }),
+                function(_signature<std::tuple<R...>, Args...>(),
+                         _member_call<T, decltype(f)>{t, f},
                          arg_names, return_names) {
         }
 
@@ -175,68 +321,61 @@ namespace ipcgull {
         function(const T* t, std::tuple<R...>(T::*f)(Args...) const,
                  const std::array<std::string, sizeof...(Args)>& arg_names,
                  const std::array<std::string, sizeof...(R)>& return_names) :
-                function(std::function<std::tuple<R...>(Args...)>(
-                                 [t, f](Args... args) -> std::tuple<R...> {
-                                     return (t->*f)(args...);
-                                 }),
+                function(_signature<std::tuple<R...>, Args...>(),
+                         _member_call<const T, decltype(f)>{t, f},
                          arg_names, return_names) {
         }
 
         template<typename... R>
         function(const std::function<std::tuple<R...>()>& f,
                  const std::array<std::string, sizeof...(R)>& return_names) :
-                _f(_fn_generator<std::tuple<R...>>::make_fn(f)),
-                _return_names(return_names.begin(), return_names.end()),
-                _return_types({make_variant_type<R>()...}) {}
+                function(_signature<std::tuple<R...>>(), f,
+                         {}, return_names) {
+        }
 
         template<typename... R>
         function(std::tuple<R...>(* f)(),
                  const std::array<std::string, sizeof...(R)>& return_names) :
-                function(std::function<std::tuple<R...>()>(f), return_names) {
+                function(_signature<std::tuple<R...>>(), f,
+                         {}, return_names) {
         }
 
         template<typename T, typename... R>
         function(T* t, std::tuple<R...>(T::*f)(),
                  const std::array<std::string, sizeof...(R)>& return_names) :
-                function(std::function<std::tuple<R...>()>(
-                                 [t, f]() -> std::tuple<R...> {
-                                     return (t->*f)();
-                                 }),
-                         return_names) {
+                function(_signature<std::tuple<R...>>(),
+                         _member_call<T, decltype(f)>{t, f},
+                         {}, return_names) {
         }
 
         template<typename T, typename... R>
         function(T* t, std::tuple<R...>(T::*f)() const,
                  const std::array<std::string, sizeof...(R)>& return_names) :
-                function(std::function<std::tuple<R...>()>(
-                                 [t, f]() -> std::tuple<R...> {
-                                     return (t->*f)();
-                                 }),
-                         return_names) {
+                function(_signature<std::tuple<R...>>(),
+                         _member_call<T, decltype(f)>{t, f},
+                         {}, return_names) {
         }
 
         template<typename T, typename... R>
         function(const T* t, std::tuple<R...>(T::*f)() const,
                  const std::array<std::string, sizeof...(R)>& return_names) :
-                function(std::function<std::tuple<R...>()>(
-                                 [t, f]() -> std::tuple<R...> {
-                                     return (t->*f)();
-                                 }),
-                         return_names) {
+                function(_signature<std::tuple<R...>>(),
+                         _member_call<const T, decltype(f)>{t, f},
+                         {}, return_names) {
         }
 
         template<typename R, typename... Args>
         function(const std::function<R(Args...)>& f,
                  const std::array<std::string, sizeof...(Args)>& arg_names,
                  const std::array<std::string, 1>& return_names) :
-                _f(_fn_generator<R, Args...>::make_fn(f)),
-                _arg_names(arg_names.begin(), arg_names.end()),
-                _arg_types({make_variant_type<Args>()...}),
-                _return_names(return_names.begin(), return_names.end()),
-                _return_types({make_variant_type<R>()}) {
-            static_assert(!is_specialization<R, std::tuple>::value,
+                function(_signature<R, Args...>(), f,
+                         arg_names, return_names) {
+            static_assert(!is_specialization<
+                                  typename result_value<R>::type,
+                                  std::tuple>::value,
                           "Invalid function construction for tuple return type");
-            static_assert(!std::is_same<R, void>::value,
+            static_assert(!std::is_same<R, void>::value &&
+                          !std::is_same<R, result<void>>::value,
                           "Invalid return name for void return type");
         }
 
@@ -244,7 +383,7 @@ namespace ipcgull {
         function(R(* f)(Args...),
                  const std::array<std::string, sizeof...(Args)>& arg_names,
                  const std::array<std::string, 1>& return_names) :
-                function(std::function<R(Args...)>(f),
+                function(_signature<R, Args...>(), f,
                          arg_names, return_names) {
         }
 
@@ -252,8 +391,8 @@ namespace ipcgull {
         function(T* t, R(T::*f)(Args...),
                  const std::array<std::string, sizeof...(Args)>& arg_names,
                  const std::array<std::string, 1>& return_names) :
-                function(std::function<R(Args...)>(
-                                 [t, f](Args... args) -> R { return (t->*f)(args...); }),
+                function(_signature<R, Args...>(),
+                         _member_call<T, decltype(f)>{t, f},
                          arg_names, return_names) {
         }
 
@@ -261,8 +400,8 @@ namespace ipcgull {
         function(T* t, R(T::*f)(Args...) const,
                  const std::array<std::string, sizeof...(Args)>& arg_names,
                  const std::array<std::string, 1>& return_names) :
-                function(std::function<R(Args...)>(
-                                 [t, f](Args... args) -> R { return (t->*f)(args...); }),
+                function(_signature<R, Args...>(),
+                         _member_call<T, decltype(f)>{t, f},
                          arg_names, return_names) {
         }
 
@@ -270,107 +409,185 @@ namespace ipcgull {
         function(const T* t, R(T::*f)(Args...) const,
                  const std::array<std::string, sizeof...(Args)>& arg_names,
                  const std::array<std::string, 1>& return_names) :
-                function(std::function<R(Args...)>(
-                                 [t, f](Args... args) -> R { return (t->*f)(args...); }),
+                function(_signature<R, Args...>(),
+                         _member_call<const T, decltype(f)>{t, f},
                          arg_names, return_names) {
         }
 
         template<typename R>
         function(const std::function<R()>& f,
                  const std::array<std::string, 1>& return_names) :
-                _f(_fn_generator<R>::make_fn(f)),
-                _return_names(return_names.begin(), return_names.end()),
-                _return_types({make_variant_type<R>()}) {
-            static_assert(!is_specialization<R, std::tuple>::value,
+                function(_signature<R>(), f,
+                         {}, return_names) {
+            static_assert(!is_specialization<
+                                  typename result_value<R>::type,
+                                  std::tuple>::value,
                           "Invalid function construction for tuple return type");
-            static_assert(!std::is_same<R, void>::value,
+            static_assert(!std::is_same<R, void>::value &&
+                          !std::is_same<R, result<void>>::value,
                           "Invalid return name for void return type");
         }
 
         template<typename R>
         function(R(* f)(),
                  const std::array<std::string, 1>& return_names) :
-                function(std::function<R()>(f), arg_names, return_names) {
+                function(_signature<R>(), f,
+                         {}, return_names) {
         }
 
         template<typename T, typename R>
         function(T* t, R(T::*f)(),
                  const std::array<std::string, 1>& return_names) :
-                function(std::function<R()>([t, f]() -> R { return (t->*f)(); }),
+                function(_signature<R>(),
+                         _member_call<T, decltype(f)>{t, f},
                          {}, return_names) {
         }
 
         template<typename T, typename R>
         function(T* t, R(T::*f)() const,
                  const std::array<std::string, 1>& return_names) :
-                function(std::function<R()>([t, f]() -> R { return (t->*f)(); }),
+                function(_signature<R>(),
+                         _member_call<T, decltype(f)>{t, f},
                          {}, return_names) {
         }
 
         template<typename T, typename R>
         function(const T* t, R(T::*f)() const,
                  const std::array<std::string, 1>& return_names) :
-                function(std::function<R()>([t, f]() -> R { return (t->*f)(); }),
+                function(_signature<R>(),
+                         _member_call<const T, decltype(f)>{t, f},
                          {}, return_names) {
         }
 
         template<typename... Args>
         function(const std::function<void(Args...)>& f,
                  const std::array<std::string, sizeof...(Args)>& arg_names) :
-                _f(_fn_generator<void, Args...>::make_fn(f)),
-                _arg_names(arg_names.begin(), arg_names.end()),
-                _arg_types({make_variant_type<Args>()...}) {}
+                function(_signature<void, Args...>(), f,
+                         arg_names, _no_names()) {
+        }
 
         template<typename... Args>
         function(void(* f)(Args...),
                  const std::array<std::string, sizeof...(Args)>& arg_names) :
-                function(std::function<void(Args...)>(f),
-                         arg_names) {
+                function(_signature<void, Args...>(), f,
+                         arg_names, _no_names()) {
         }
 
         template<typename T, typename... Args>
         function(T* t, void(T::*f)(Args...),
                  const std::array<std::string, sizeof...(Args)>& arg_names) :
-                function(std::function<void(Args...)>(
-                                 [t, f](Args... args) { (t->*f)(args...); }),
-                         arg_names) {
+                function(_signature<void, Args...>(),
+                         _member_call<T, decltype(f)>{t, f},
+                         arg_names, _no_names()) {
         }
 
         template<typename T, typename... Args>
         function(T* t, void(T::*f)(Args...) const,
                  const std::array<std::string, sizeof...(Args)>& arg_names) :
-                function(std::function<void(Args...)>(
-                                 [t, f](Args... args) { (t->*f)(args...); }),
-                         arg_names) {
+                function(_signature<void, Args...>(),
+                         _member_call<T, decltype(f)>{t, f},
+                         arg_names, _no_names()) {
         }
 
         template<typename T, typename... Args>
         function(const T* t, void(T::*f)(Args...) const,
                  const std::array<std::string, sizeof...(Args)>& arg_names) :
-                function(std::function<void(Args...)>(
-                                 [t, f](Args... args) { (t->*f)(args...); }),
-                         arg_names) {
+                function(_signature<void, Args...>(),
+                         _member_call<const T, decltype(f)>{t, f},
+                         arg_names, _no_names()) {
+        }
+
+        template<typename... Args>
+        function(const std::function<result<void>(Args...)>& f,
+                 const std::array<std::string, sizeof...(Args)>& arg_names) :
+                function(_signature<result<void>, Args...>(), f,
+                         arg_names, _no_names()) {
+        }
+
+        template<typename... Args>
+        function(result<void>(* f)(Args...),
+                 const std::array<std::string, sizeof...(Args)>& arg_names) :
+                function(_signature<result<void>, Args...>(), f,
+                         arg_names, _no_names()) {
+        }
+
+        template<typename T, typename... Args>
+        function(T* t, result<void>(T::*f)(Args...),
+                 const std::array<std::string, sizeof...(Args)>& arg_names) :
+                function(_signature<result<void>, Args...>(),
+                         _member_call<T, decltype(f)>{t, f},
+                         arg_names, _no_names()) {
+        }
+
+        template<typename T, typename... Args>
+        function(T* t, result<void>(T::*f)(Args...) const,
+                 const std::array<std::string, sizeof...(Args)>& arg_names) :
+                function(_signature<result<void>, Args...>(),
+                         _member_call<T, decltype(f)>{t, f},
+                         arg_names, _no_names()) {
+        }
+
+        template<typename T, typename... Args>
+        function(const T* t, result<void>(T::*f)(Args...) const,
+                 const std::array<std::string, sizeof...(Args)>& arg_names) :
+                function(_signature<result<void>, Args...>(),
+                         _member_call<const T, decltype(f)>{t, f},
+                         arg_names, _no_names()) {
         }
 
         function(const std::function<void()>& f) :
-                _f(_fn_generator<void>::make_fn(f)) {}
+                function(_signature<void>(), f,
+                         {}, _no_names()) {
+        }
 
-        function(void(* f)()) : function(std::function<void()>(f)) {}
+        function(void(* f)()) :
+                function(_signature<void>(), f,
+                         {}, _no_names()) {
+        }
 
         template<typename T>
         function(T* t, void(T::*f)()) :
-                function(std::function<void()>([t, f]() { (t->*f)(); })) {}
+                function(_signature<void>(),
+                         _member_call<T, decltype(f)>{t, f},
+                         {}, _no_names()) {
+        }
 
         template<typename T>
         function(T* t, void(T::*f)() const) :
-                function(std::function<void()>([t, f]() { (t->*f)(); })) {}
+                function(_signature<void>(),
+                         _member_call<T, decltype(f)>{t, f},
+                         {}, _no_names()) {
+        }
 
         template<typename T>
         function(const T* t, void(T::*f)() const) :
-                function(std::function<void()>([t, f]() { (t->*f)(); })) {}
+                function(_signature<void>(),
+                         _member_call<const T, decltype(f)>{t, f},
+                         {}, _no_names()) {
+        }
 
+        // Handler exceptions propagate, decoding and handler-returned
+        // errors are raised as exceptions
         variant_tuple operator()(const variant_tuple& args) const;
 
+        // Reports bad arguments and handler-returned errors without
+        // throwing. Exceptions thrown by the handler itself still propagate.
+        [[nodiscard]] result<variant_tuple> invoke(
+                const variant_tuple& args) const;
+
+        // Deadline given to each call's context, zero (the default)
+        // disables it. Handlers may check it to skip or abort work; a
+        // reply they do produce is always sent.
+        function& set_timeout(std::chrono::milliseconds timeout);
+
+        [[nodiscard]] std::chrono::milliseconds timeout() const;
+
+        // Also cancel each call's context if the caller leaves the bus. The
+        // first call from each sender costs the server a GetNameOwner.
+        function& set_cancel_on_disconnect(bool cancel = true);
+
+        [[nodiscard]] bool cancel_on_disconnect() const;
+
         [[nodiscard]] const std::vector<std::string>& arg_names() const;
 
         [[nodiscard]] const std::vector<variant_type>& arg_types() const;
@@ -19,11 +19,17 @@
 #ifndef IPCGULL_INTERFACE_H
 #define IPCGULL_INTERFACE_H
 
+#include <atomic>
+#include <memory>
+#include <set>
+#include <shared_mutex>
+#include <stdexcept>
 #include <string>
-#include <map>
+#include <string_view>
 #include <ipcgull/function.h>
 #include <ipcgull/property.h>
 #include <ipcgull/signal.h>
+#include <ipcgull/table.h>
 
 namespace ipcgull {
     class function;
@@ -34,12 +40,53 @@ namespace ipcgull {
 
     class node;
 
+    template<typename... Args>
+    class signal_handle;
+
     class interface {
     public:
-        typedef std::map<std::string, function> function_table;
-        typedef std::map<std::string, base_property> property_table;
-        typedef std::map<std::string, signal> signal_table;
+        struct property_value {
+            const std::string* name;
+            const base_property* property;
+            // property->version() from before the read
+            uint64_t version;
+            variant value;
+        };
+
+        typedef frozen_table<function> function_table;
+        typedef frozen_table<base_property> property_table;
+        typedef frozen_table<signal> signal_table;
         typedef std::tuple<function_table, property_table, signal_table> tables;
+
+        // Applies several property writes as one update. Until it is
+        // committed or destroyed, read_properties() (and so Get, GetAll
+        // and PropertiesChanged) waits for it, and the changes are held
+        // back to be announced together. Writers that do not open a
+        // transaction are not excluded, and direct reads through the
+        // property objects do not wait: only the server's reads see the
+        // update as a whole. A nested transaction on the same interface
+        // joins the outer one.
+        // Signals may be emitted inside it: servers never wait for it while
+        // holding their own lock.
+        class transaction {
+            const interface* _iface;
+            std::unique_lock<std::shared_mutex> _lock;
+            std::set<std::string> _changed;
+            transaction* _previous;
+
+            friend class interface;
+
+        public:
+            explicit transaction(const interface& iface);
+
+            ~transaction();
+
+            transaction(const transaction&) = delete;
+
+            transaction& operator=(const transaction&) = delete;
+
+            void commit();
+        };
     private:
         const std::string _name;
         const function_table _functions;
@@ -49,14 +96,80 @@ namespace ipcgull {
         // The node should take ownership of the interface
         friend class node;
 
+        friend class base_property;
+
+        template<typename...>
+        friend class signal_handle;
+
         std::weak_ptr<node> _owner;
 
+        mutable std::shared_mutex _transaction_lock;
+
+        // Bumped on every property write, see property_changed_at()
+        mutable std::atomic<uint64_t> _properties_version{0};
+        const uint64_t _generation;
+        // Indexed like _properties
+        std::unique_ptr<std::atomic<uint64_t>[]> _changed_at;
+
+        void _listen_properties(
+                const std::weak_ptr<const interface>& self) const;
+
+        void _unlisten_properties() const;
+
+        void _property_changed(const std::string& property) const;
+
+        void _announce_change(const std::string& property) const;
+
+        void _property_delta(const std::string& property,
+                             const std::vector<variant>& args,
+                             const signal& delta_signal) const;
+
         // Assumes types are checked
         [[maybe_unused]]
         void _emit_signal(const std::string& signal,
                           const std::vector<variant>& args,
                           const variant_type& args_type) const;
 
+        // Broadcast if destinations is empty
+        void _emit_payload(const std::string& signal,
+                           const signal_policy& policy,
+                           const signal_payload& payload,
+                           const std::vector<std::string>& destinations)
+                           const;
+
+        // Checks the payload's type against the signal
+        void _emit_payload(const std::string& signal,
+                           const signal_payload& payload,
+                           const std::vector<std::string>& destinations)
+                           const;
+
+        template<typename... Args>
+        void _emit_checked(const std::vector<std::string>& destinations,
+                           const std::string& signal, Args... args) const {
+            try {
+                const auto& s = _signals.at(signal);
+                const auto& expected_types = s.types;
+                if (sizeof...(Args) != expected_types.size())
+                    throw std::runtime_error("invalid ipc signal arg count");
+
+                std::vector<variant_type> v_types =
+                        {make_variant_type<Args>()...};
+                auto mismatch = std::mismatch(v_types.begin(),
+                                              v_types.end(),
+                                              expected_types.begin());
+                if (mismatch.first != v_types.end() ||
+                    mismatch.second != expected_types.end())
+                    throw std::runtime_error("invalid ipc signal arg type");
+
+                std::vector<variant> v_args = {to_variant(args)...};
+                _emit_payload(signal, s.policy,
+                              signal_payload(std::move(v_args), s.args_type),
+                              destinations);
+            } catch (std::out_of_range& e) {
+                throw std::runtime_error("unknown ipc signal emitted");
+            }
+        }
+
     public:
         interface(std::string name,
                   function_table f,
@@ -87,32 +200,153 @@ namespace ipcgull {
 
         [[nodiscard]] base_property& get_property(const std::string& name);
 
+        // nullptr if the property does not exist
+        [[nodiscard]] const base_property* find_property(
+                std::string_view name) const;
+
+        [[nodiscard]] base_property* find_property(std::string_view name);
+
+        // Reads every readable property accepted by filter (all if null),
+        // taking each distinct lock once. filter runs with transactions
+        // excluded, so it sees the same state as the read.
+        [[nodiscard]] std::vector<property_value> read_properties(
+                const std::function<bool(const std::string&,
+                                         const base_property&)>& filter =
+                nullptr) const;
+
         template<typename... Args>
         [[maybe_unused]]
         void emit_signal(
                 const std::string& signal, Args... args) const {
-            try {
-                const auto& expected_types = _signals.at(signal).types;
-                if (sizeof...(Args) != expected_types.size())
-                    throw std::runtime_error("invalid ipc signal arg count");
+            _emit_checked({}, signal, std::forward<Args>(args)...);
+        }
 
-                std::vector<variant_type> v_types =
-                        {make_variant_type<Args>()...};
-                auto mismatch = std::mismatch(v_types.begin(),
-                                              v_types.end(),
-                                              expected_types.begin());
-                if (mismatch.first != v_types.end() ||
-                    mismatch.second != expected_types.end())
-                    throw std::runtime_error("invalid ipc signal arg type");
+        // Sends the signal to one unique bus name instead of broadcasting
+        template<typename... Args>
+        [[maybe_unused]]
+        void emit_signal_to(const std::string& destination,
+                            const std::string& signal, Args... args) const {
+            if (destination.empty())
+                throw std::invalid_argument("empty signal destination");
+            _emit_checked({destination}, signal,
+                          std::forward<Args>(args)...);
+        }
 
-                _emit_signal(signal, {to_variant(args)...},
-                             variant_type::tuple(v_types));
-            } catch (std::out_of_range& e) {
-                throw std::runtime_error("unknown ipc signal emitted");
-            }
+        // Marshals once and sends a copy to each destination. Sends
+        // nothing if destinations is empty.
+        template<typename... Args>
+        [[maybe_unused]]
+        void emit_signal_to(const std::vector<std::string>& destinations,
+                            const std::string& signal, Args... args) const {
+            if (destinations.empty())
+                return;
+            _emit_checked(destinations, signal,
+                          std::forward<Args>(args)...);
+        }
+
+        // Emits arguments marshalled beforehand, so that many objects can
+        // announce the same event without marshalling it each time
+        [[maybe_unused]]
+        void emit_payload(const std::string& signal,
+                          const signal_payload& payload) const;
+
+        [[maybe_unused]]
+        void emit_payload_to(const std::string& destination,
+                             const std::string& signal,
+                             const signal_payload& payload) const;
+
+        [[maybe_unused]]
+        void emit_payload_to(const std::vector<std::string>& destinations,
+                             const std::string& signal,
+                             const signal_payload& payload) const;
+
+        // Checks the signal's types once and returns a handle that emits
+        // it without looking it up. The handle refers to this interface
+        // and must not outlive it.
+        template<typename... Args>
+        [[nodiscard]] signal_handle<Args...> bind_signal(
+                const std::string& signal) const {
+            auto it = _signals.find(signal);
+            if (it == _signals.end())
+                throw std::runtime_error("unknown ipc signal");
+
+            std::vector<variant_type> v_types =
+                    {make_variant_type<Args>()...};
+            if (v_types != it->second.types)
+                throw std::runtime_error("invalid ipc signal arg type");
+
+            return signal_handle<Args...>(this, &it->first, &it->second);
+        }
+
+        template<typename... Args>
+        [[nodiscard]] signal_handle<Args...> bind_signal(
+                const std::string& signal,
+                const typed_signal<Args...>&) const {
+            return bind_signal<Args...>(signal);
         }
 
         [[nodiscard]] const std::string& name() const;
+
+        // Starts at 0 and increases with every write to a property
+        [[nodiscard]] uint64_t properties_version() const;
+
+        // Non-zero and unique to this instance, even across processes.
+        // Versions from another generation say nothing about this one.
+        [[nodiscard]] uint64_t generation() const;
+
+        // properties_version() as of the property's last write, 0 if it
+        // has not been written since the interface was created
+        [[nodiscard]] uint64_t property_changed_at(
+                std::string_view property) const;
+    };
+
+    // Returned by interface::bind_signal
+    template<typename... Args>
+    class signal_handle {
+        const interface* _iface;
+        const std::string* _name;
+        const signal* _signal;
+
+        friend class interface;
+
+        signal_handle(const interface* iface, const std::string* name,
+                      const signal* signal) :
+                _iface(iface), _name(name), _signal(signal) {
+        }
+
+    public:
+        // Can also be emitted from other interfaces with emit_payload
+        [[nodiscard]] signal_payload payload(Args... args) const {
+            return {std::vector<variant>{to_variant(args)...},
+                    _signal->args_type};
+        }
+
+        [[maybe_unused]]
+        void emit(Args... args) const {
+            _iface->_emit_payload(*_name, _signal->policy,
+                                  payload(args...), {});
+        }
+
+        [[maybe_unused]]
+        void emit_to(const std::string& destination, Args... args) const {
+            if (destination.empty())
+                throw std::invalid_argument("empty signal destination");
+            _iface->_emit_payload(*_name, _signal->policy,
+                                  payload(args...), {destination});
+        }
+
+        [[maybe_unused]]
+        void emit_to(const std::vector<std::string>& destinations,
+                     Args... args) const {
+            if (destinations.empty())
+                return;
+            _iface->_emit_payload(*_name, _signal->policy,
+                                  payload(args...), destinations);
+        }
+
+        [[nodiscard]] const std::string& name() const {
+            return *_name;
+        }
     };
 }
 
@@ -34,9 +34,23 @@ namespace ipcgull {
     class server;
 
     class node {
-        std::map<std::string, std::weak_ptr<interface>> _interfaces;
-        std::list<std::weak_ptr<server>> _servers;
+    public:
+        // Transparent, so backends can look up by C string
+        typedef std::map<std::string, std::weak_ptr<interface>, std::less<>>
+                interface_map;
+    private:
+        struct server_path {
+            std::weak_ptr<server> ptr;
+            // full_name(*server)
+            std::string path;
+        };
+
+        interface_map _interfaces;
+        std::list<server_path> _servers;
         std::string _name;
+        // Fixed on construction: when a parent is destroyed, the children
+        // it hands to its own parent keep the same path.
+        std::string _tree_name;
 
         const std::shared_ptr<std::recursive_mutex> _hierarchy_lock;
         std::weak_ptr<const node> _parent;
@@ -51,11 +65,18 @@ namespace ipcgull {
         // Assumes that types are already checked
         void emit_signal(const std::string& iface,
                          const std::string& signal,
-                         const variant_tuple& args,
-                         const variant_type& args_type) const;
+                         const signal_payload& payload,
+                         const signal_policy& policy,
+                         const std::vector<std::string>& destinations)
+                         const;
+
+        void properties_changed(const std::string& iface,
+                                const std::string& property) const;
 
         friend class _node;
 
+        void _add_interface(const std::shared_ptr<interface>& ptr);
+
         explicit node(std::string name);
 
         explicit node(std::string name,
@@ -80,33 +101,7 @@ namespace ipcgull {
             static_assert(std::is_base_of<interface, T>::value,
                           "T must be an interface");
             auto ptr = std::make_shared<T>(std::forward<Args&&>(args)...);
-
-            if (_interfaces.count(ptr->name()))
-                throw std::invalid_argument("duplicate interface");
-
-            assert(!_self.expired());
-
-            {
-                std::list<std::shared_ptr<server>> added_servers;
-                try {
-                    for (auto& s: _servers) {
-                        if (auto server = s.lock()) {
-                            server->add_interface(_self.lock(), *ptr);
-                            added_servers.push_front(server);
-                        }
-                    }
-                } catch (std::exception& e) {
-                    while (!added_servers.empty()) {
-                        auto& s = added_servers.front();
-                        s->drop_interface(full_name(*s), ptr->name());
-                        added_servers.pop_front();
-                    }
-                    throw;
-                }
-            }
-
-            ptr->_owner = _self;
-            _interfaces.emplace(ptr->name(), ptr);
+            _add_interface(ptr);
 
             return ptr;
         }
@@ -121,15 +116,14 @@ namespace ipcgull {
 
         [[nodiscard]] const std::weak_ptr<object>& managed() const;
 
-        [[nodiscard]] const std::map<std::string, std::weak_ptr<interface>>&
-        interfaces() const;
+        [[nodiscard]] const interface_map& interfaces() const;
 
         [[nodiscard]] const std::string& name() const;
 
         // This should be provided by backend code.
         [[nodiscard]] std::string full_name(const server& s) const;
 
-        [[nodiscard]] std::string tree_name() const;
+        [[nodiscard]] const std::string& tree_name() const;
     };
 }
 
@@ -0,0 +1,58 @@
+/*
+ * Copyright 2022 PixlOne
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef IPCGULL_OBSERVER_H
+#define IPCGULL_OBSERVER_H
+
+#include <cstdint>
+#include <string_view>
+
+namespace ipcgull {
+    enum span_kind : uint8_t {
+        span_decode,
+        span_handler,
+        span_encode,
+        span_signal_emit,
+        span_registration
+    };
+
+    // Views are only valid for the duration of the callback
+    struct span_info {
+        span_kind kind;
+        std::string_view object_path;
+        std::string_view interface;
+        std::string_view member;
+        std::string_view sender;
+        // Serialized size of the message body, 0 when unknown. On encode
+        // spans it is only set in end().
+        std::size_t payload_size;
+    };
+
+    // Installed with server::set_observer. Callbacks run on the thread
+    // doing the work, with the server lock held, and must not throw.
+    class observer {
+    public:
+        virtual ~observer() = default;
+
+        virtual void begin(const span_info& span) = 0;
+
+        virtual void end(const span_info& span) = 0;
+    };
+}
+
+#endif //IPCGULL_OBSERVER_H
@@ -19,13 +19,24 @@
 #ifndef IPCGULL_PROPERTY_H
 #define IPCGULL_PROPERTY_H
 
+#include <array>
+#include <atomic>
 #include <cassert>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <exception>
 #include <functional>
 #include <memory>
 #include <mutex>
 #include <list>
+#include <optional>
+#include <thread>
+#include <type_traits>
+#include <vector>
 #include <ipcgull/variant.h>
 #include <ipcgull/exception.h>
+#include <ipcgull/signal.h>
 
 namespace ipcgull {
     template<typename T, typename Lock>
@@ -43,29 +54,45 @@ namespace ipcgull {
         return to_variant(*data);
     }
 
-    template<typename T>
-    static bool _validate_input(std::function<bool(const T&)> validate,
-                                const variant& input) {
-        return validate(from_variant<T>(input));
+    template<typename Lock>
+    static std::function<void(bool)> _lock_fn(
+            const std::shared_ptr<Lock>& lock) {
+        return [lock](bool acquire) {
+            if (acquire)
+                lock->lock();
+            else
+                lock->unlock();
+        };
     }
 
-    template<typename T, typename Lock>
-    static bool _set_property(const std::shared_ptr<T>& data,
-                              const variant& input,
-                              const std::shared_ptr<Lock>& lock) {
-        assert(lock);
-        assert(data);
-        std::lock_guard<Lock> guard(*lock);
-        *data = from_variant<T>(input);
-        return true;
+    // Decodes input once, checks the decoded value with validate (if set)
+    // and hands it to store to be moved into place
+    template<typename T, typename Store>
+    static result<void> _write_property(
+            const variant& input,
+            const std::function<bool(const T&)>& validate,
+            Store&& store) {
+        auto value = try_from_variant<T>(input);
+        if (!value)
+            return value.error();
+        if (validate && !validate(*value))
+            return call_error(error_invalid_args, "Invalid property value");
+        store(std::move(*value));
+        return {};
     }
 
-    template<typename T>
-    static bool _set_property(const std::shared_ptr<T>& data,
-                              const variant& input) {
+    template<typename T, typename Lock>
+    static result<void> _set_property(
+            const std::shared_ptr<T>& data,
+            const variant& input,
+            const std::function<bool(const T&)>& validate,
+            const std::shared_ptr<Lock>& lock) {
+        assert(lock);
         assert(data);
-        *data = from_variant<T>(input);
-        return true;
+        return _write_property(input, validate, [&](T&& value) {
+            std::lock_guard<Lock> guard(*lock);
+            *data = std::move(value);
+        });
     }
 
     enum property_permissions : uint8_t {
@@ -75,18 +102,308 @@ namespace ipcgull {
         property_full_permissions = 0b11
     };
 
+    // Lock tags for property<T, Lock>. Both need a trivially copyable T and
+    // never block readers: lock_free keeps the value in a std::atomic<T>,
+    // seqlock in a sequence-locked buffer for values too wide for that.
+    struct lock_free {
+    };
+
+    struct seqlock {
+    };
+
+    // Lock tag for large values (containers). Each write publishes a new
+    // immutable version; readers share the current one without copying.
+    struct snapshot {
+    };
+
+    template<typename T>
+    class _atomic_cell {
+        std::atomic<T> _value;
+    public:
+        explicit _atomic_cell(T value) : _value(value) {
+        }
+
+        T load() const {
+            return _value.load(std::memory_order_acquire);
+        }
+
+        variant get() const {
+            return to_variant(load());
+        }
+
+        void store(const T& value) {
+            _value.store(value, std::memory_order_release);
+        }
+    };
+
+    // Writers are serialized by a mutex readers never touch. Readers retry
+    // if a write overlapped their copy.
+    template<typename T>
+    class _seqlock_cell {
+        static constexpr std::size_t word_count =
+                (sizeof(T) + sizeof(std::uintptr_t) - 1) /
+                sizeof(std::uintptr_t);
+        typedef std::array<std::uintptr_t, word_count> words;
+
+        std::atomic<uint64_t> _seq{0};
+        std::array<std::atomic<std::uintptr_t>, word_count> _words;
+        std::mutex _write_lock;
+
+        void _publish(const T& value) {
+            words w{};
+            std::memcpy(w.data(), &value, sizeof(T));
+            for (std::size_t i = 0; i < word_count; ++i)
+                _words[i].store(w[i], std::memory_order_relaxed);
+        }
+
+    public:
+        explicit _seqlock_cell(const T& value) {
+            _publish(value);
+        }
+
+        T load() const {
+            words w;
+            for (;;) {
+                const auto seq = _seq.load(std::memory_order_acquire);
+                if (seq & 1) {
+                    std::this_thread::yield();
+                    continue;
+                }
+                for (std::size_t i = 0; i < word_count; ++i)
+                    w[i] = _words[i].load(std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (_seq.load(std::memory_order_relaxed) == seq)
+                    break;
+            }
+
+            T ret;
+            std::memcpy(&ret, w.data(), sizeof(T));
+            return ret;
+        }
+
+        variant get() const {
+            return to_variant(load());
+        }
+
+        void store(const T& value) {
+            std::lock_guard<std::mutex> lock(_write_lock);
+            const auto seq = _seq.load(std::memory_order_relaxed);
+            _seq.store(seq + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+            _publish(value);
+            _seq.store(seq + 2, std::memory_order_release);
+        }
+    };
+
+    template<typename T>
+    class _snapshot_cell {
+        std::shared_ptr<const T> _value;
+    public:
+        explicit _snapshot_cell(std::shared_ptr<const T> value) :
+                _value(std::move(value)) {
+        }
+
+        std::shared_ptr<const T> load() const {
+            return std::atomic_load_explicit(&_value,
+                                             std::memory_order_acquire);
+        }
+
+        variant get() const {
+            return to_variant(*load());
+        }
+
+        void store(std::shared_ptr<const T> value) {
+            std::atomic_store_explicit(&_value, std::move(value),
+                                       std::memory_order_release);
+        }
+
+        void store(T value) {
+            store(std::make_shared<const T>(std::move(value)));
+        }
+
+        // Applies f to a copy of the current version and publishes it,
+        // retrying if another writer got there first
+        template<typename F>
+        void update(F&& f) {
+            auto current = load();
+            for (;;) {
+                auto next = std::make_shared<T>(*current);
+                f(*next);
+                std::shared_ptr<const T> value = std::move(next);
+                if (std::atomic_compare_exchange_weak_explicit(
+                        &_value, &current, value,
+                        std::memory_order_acq_rel,
+                        std::memory_order_acquire))
+                    return;
+            }
+        }
+    };
+
+    // Values come from a getter, cached for ttl. Concurrent reads of an
+    // expired value share a single call to the getter.
+    template<typename T>
+    class _computed_cell {
+        typedef std::chrono::steady_clock clock;
+
+        const std::function<T()> _getter;
+        const std::function<void(const T&)> _setter;
+        const clock::duration _ttl;
+
+        mutable std::mutex _lock;
+        mutable std::condition_variable _done;
+        mutable bool _computing = false;
+        mutable uint64_t _generation = 0;
+        mutable std::optional<T> _value;
+        mutable std::exception_ptr _error;
+        mutable clock::time_point _expires;
+
+    public:
+        _computed_cell(std::function<T()> getter,
+                       std::function<void(const T&)> setter,
+                       clock::duration ttl) :
+                _getter(std::move(getter)), _setter(std::move(setter)),
+                _ttl(ttl) {
+            if (!_getter)
+                throw std::invalid_argument("null getter");
+        }
+
+        T load() const {
+            std::unique_lock<std::mutex> lock(_lock);
+            while (_computing) {
+                const auto generation = _generation;
+                _done.wait(lock, [this, generation]() {
+                    return _generation != generation;
+                });
+                if (_error)
+                    std::rethrow_exception(_error);
+                // Invalidated before this reader woke up, another may
+                // already have started the next call
+                if (_value)
+                    return *_value;
+            }
+            if (_value && clock::now() < _expires)
+                return *_value;
+
+            _computing = true;
+            lock.unlock();
+            std::optional<T> value;
+            std::exception_ptr error;
+            try {
+                value = _getter();
+            } catch (...) {
+                error = std::current_exception();
+            }
+            lock.lock();
+
+            // Without a ttl, the value is kept only for the readers that
+            // waited on this call, as it has already expired
+            _computing = false;
+            ++_generation;
+            _error = error;
+            _value = value;
+            _expires = clock::now() + _ttl;
+            _done.notify_all();
+            lock.unlock();
+
+            if (error)
+                std::rethrow_exception(error);
+            return std::move(*value);
+        }
+
+        variant get() const {
+            return to_variant(load());
+        }
+
+        void store(const T& value) {
+            if (!_setter)
+                throw std::logic_error("property has no setter");
+            _setter(value);
+            invalidate();
+        }
+
+        void invalidate() {
+            std::lock_guard<std::mutex> lock(_lock);
+            _value.reset();
+        }
+    };
+
+    template<typename T>
+    struct _cell_storage {
+    };
+
     class interface;
 
+    // Shared by every copy of a property, so that a change made through
+    // the user's copy reaches the interfaces holding the others.
+    struct _property_state {
+        struct listener {
+            std::weak_ptr<const interface> iface;
+            std::string name;
+        };
+
+        std::mutex lock;
+        std::vector<listener> listeners;
+        std::vector<std::pair<uint64_t, std::function<void()>>> observers;
+        uint64_t next_observer = 0;
+
+        std::atomic<uint64_t> version{0};
+        std::mutex cache_lock;
+        uint64_t cache_version = 0;
+        std::shared_ptr<const void> cache;
+    };
+
+    // Runs a task, e.g. by posting it to a thread pool or event loop
+    typedef std::function<void(std::function<void()>)> executor;
+
+    // Removes a property observer when destroyed
+    class subscription {
+        std::weak_ptr<_property_state> _state;
+        uint64_t _id = 0;
+
+        friend class base_property;
+
+        subscription(std::weak_ptr<_property_state> state, uint64_t id);
+
+    public:
+        subscription() = default;
+
+        subscription(subscription&& o) noexcept;
+
+        subscription& operator=(subscription&& o) noexcept;
+
+        subscription(const subscription&) = delete;
+
+        ~subscription();
+
+        void unsubscribe();
+    };
+
     class base_property {
     private:
         const variant_type _type;
         property_permissions _perms;
         std::function<variant()> _get;
-        std::function<bool(const variant&)> _validate;
-        std::function<bool(const variant&)> _set;
+        // Decodes, validates and stores
+        std::function<result<void>(const variant&)> _set;
+        // Used by interface::read_properties() to read the properties
+        // sharing a lock under a single acquisition
+        std::function<variant()> _get_unlocked;
+        const void* _lock_id;
+        std::function<void(bool)> _lock_op;
+        // False if the value can change without a write
+        bool _cacheable = true;
+        std::shared_ptr<_property_state> _state =
+                std::make_shared<_property_state>();
+        // Declared as <name>ElementsChanged on the holding interfaces
+        std::optional<signal> _delta_signal;
 
         friend class interface;
 
+        void _listen(const std::weak_ptr<const interface>& iface,
+                     const std::string& name) const;
+
+        void _unlisten(const interface* iface) const;
+
     protected:
         template<typename T, typename Lock>
         base_property(property_permissions mode,
@@ -96,10 +413,13 @@ namespace ipcgull {
                 _get([target, lock]() -> variant {
                     return _get_property(target, lock);
                 }),
-                _validate([](const variant&) -> bool { return true; }),
-                _set([target, lock](const variant& v) -> bool {
-                    return _set_property(target, v, lock);
-                }) {
+                _set([target, lock](const variant& v) -> result<void> {
+                    return _set_property<T>(target, v, nullptr, lock);
+                }),
+                _get_unlocked([target]() -> variant {
+                    return _get_property(target);
+                }),
+                _lock_id(lock.get()), _lock_op(_lock_fn(lock)) {
             if (!target || !lock)
                 throw std::runtime_error("null property");
         }
@@ -113,12 +433,14 @@ namespace ipcgull {
                 _get([target, lock]() -> variant {
                     return _get_property(target, lock);
                 }),
-                _validate([validate](const variant& v) -> bool {
-                    return _validate_input(validate, v);
+                _set([target, validate, lock](const variant& v)
+                             -> result<void> {
+                    return _set_property(target, v, validate, lock);
+                }),
+                _get_unlocked([target]() -> variant {
+                    return _get_property(target);
                 }),
-                _set([target, lock](const variant& v) -> bool {
-                    return _set_property(target, v, lock);
-                }) {
+                _lock_id(lock.get()), _lock_op(_lock_fn(lock)) {
             if (!target || !lock)
                 throw std::runtime_error("null property");
         }
@@ -131,22 +453,98 @@ namespace ipcgull {
                 _get([target, lock]() -> variant {
                     return _get_property(target, lock);
                 }),
-                _validate([](const variant&) -> bool { return true; }),
-                _set([](const variant&) -> bool { return false; }) {
+                _set([](const variant&) -> result<void> {
+                    return call_error(error_property_read_only,
+                                      "property is constant");
+                }),
+                _get_unlocked([target]() -> variant {
+                    return _get_property(target);
+                }),
+                _lock_id(lock.get()), _lock_op(_lock_fn(lock)) {
             if (!target || !lock)
                 throw std::runtime_error("null property");
         }
 
+        // Lock-free storage, Cell provides get() and store()
+        template<typename T, typename Cell>
+        base_property(property_permissions mode,
+                      _cell_storage<T>,
+                      const std::shared_ptr<Cell>& cell,
+                      const std::function<bool(const T&)>& validate,
+                      bool cacheable = true) :
+                _type(make_variant_type<T>()), _perms(mode),
+                _get([cell]() -> variant {
+                    return cell->get();
+                }),
+                _set([cell, validate](const variant& v) -> result<void> {
+                    return _write_property(v, validate, [&cell](T&& value) {
+                        cell->store(std::move(value));
+                    });
+                }),
+                _get_unlocked(_get),
+                _lock_id(nullptr), _lock_op([](bool) {}),
+                _cacheable(cacheable) {
+            if (!cell)
+                throw std::runtime_error("null property");
+        }
+
+        // Queues PropertiesChanged on every interface holding a copy and
+        // runs the observers
         void notify_change() const;
 
+        [[nodiscard]] subscription _subscribe(std::function<void()> f) const;
+
+        // Announces changes through a delta signal of the given type; the
+        // value itself is then only invalidated by PropertiesChanged
+        void _emit_deltas(signal delta_signal);
+
+        // Emits the delta signal on every interface holding a copy
+        void notify_delta(const std::vector<variant>& args) const;
+
+        // Wraps an observer taking a shared value for an executor, or
+        // calls it in place without one
+        template<typename T>
+        static std::function<void(std::shared_ptr<const T>)> _deliver(
+                std::function<void(const T&)> f, executor exec) {
+            if (!exec) {
+                return [f](std::shared_ptr<const T> value) {
+                    f(*value);
+                };
+            }
+            return [f, exec](std::shared_ptr<const T> value) {
+                exec([f, value]() { f(*value); });
+            };
+        }
+
     public:
         [[nodiscard]] variant get_variant() const;
 
+        // Returns false if the validator rejects the value
         [[nodiscard]] bool set_variant(const variant& value);
 
+        // Non-throwing versions used by the dispatch paths
+        [[nodiscard]] result<variant> try_get_variant() const;
+
+        [[nodiscard]] result<void> try_set_variant(const variant& value);
+
         [[nodiscard]] const variant_type& type() const;
 
         [[nodiscard]] property_permissions permissions() const;
+
+        // Set for container properties announcing element-level changes
+        [[nodiscard]] const std::optional<signal>& delta_signal() const;
+
+        // Bumped after every write
+        [[nodiscard]] uint64_t version() const;
+
+        // A server backend's encoding of the value, kept until the next
+        // write. cached() returns null if `version` is no longer current
+        // or the value can change without a write (computed_property).
+        [[nodiscard]] std::shared_ptr<const void> cached(
+                uint64_t version) const;
+
+        void cache(uint64_t version,
+                   std::shared_ptr<const void> encoded) const;
     };
 
     // properties are atomic
@@ -155,14 +553,26 @@ namespace ipcgull {
         std::shared_ptr<T> _data;
         mutable std::shared_ptr<Lock> _lock;
 
+        template<typename, typename, typename>
+        friend class map_property;
+
         property(const property_permissions& perms,
-                 std::shared_ptr<T>&& data,
-                 std::shared_ptr<Lock>&& lock) :
+                 std::shared_ptr<T> data,
+                 std::shared_ptr<Lock> lock) :
                 base_property(perms, data, lock),
                 _data(std::move(data)), _lock(std::move(lock)) {
             static_assert(variant_constructable<T>::value);
         }
 
+        property(const property_permissions& perms,
+                 std::shared_ptr<T> data,
+                 const std::function<bool(const T&)>& validate,
+                 std::shared_ptr<Lock> lock) :
+                base_property(perms, data, validate, lock),
+                _data(std::move(data)), _lock(std::move(lock)) {
+            static_assert(variant_constructable<T>::value);
+        }
+
     public:
         template<typename... Args>
         property(const property_permissions& perms, Args... args) :
@@ -203,6 +613,24 @@ namespace ipcgull {
             return *_data;
         }
 
+        // Calls f with a copy of the value after every write, including
+        // remote ones, on the writing thread (the bus thread for D-Bus
+        // writes) or through exec. The copy is taken under the lock and f
+        // runs without it, so f may read or write the property.
+        [[nodiscard]] subscription subscribe(
+                std::function<void(const T&)> f,
+                executor exec = nullptr) const {
+            return _subscribe([deliver = _deliver(std::move(f), exec),
+                               data = _data, lock = _lock]() {
+                std::shared_ptr<const T> value;
+                {
+                    std::lock_guard<Lock> guard(*lock);
+                    value = std::make_shared<const T>(*data);
+                }
+                deliver(std::move(value));
+            });
+        }
+
         operator property<const T>() const {
             return property<const T, Lock>(*this);
         }
@@ -244,19 +672,324 @@ namespace ipcgull {
             return *this;
         }
 
+        // The lock is released before notifying, as the backend reads the
+        // value back under its own lock
         property& operator=(const T& o) {
-            std::lock_guard<Lock> lock(*_lock);
-            *_data = o;
+            {
+                std::lock_guard<Lock> lock(*_lock);
+                *_data = o;
+            }
             notify_change();
             return *this;
         }
 
         property& operator=(T&& o) {
-            std::lock_guard<Lock> lock(*_lock);
-            *_data = std::move(o);
+            {
+                std::lock_guard<Lock> lock(*_lock);
+                *_data = std::move(o);
+            }
+            notify_change();
+            return *this;
+        }
+    };
+
+    template<typename Derived, typename T, typename Cell>
+    class _cell_property : public base_property {
+        std::shared_ptr<Cell> _cell;
+
+        static_assert(std::is_trivially_copyable<T>::value,
+                      "lock-free properties need a trivially copyable T");
+
+        _cell_property(const property_permissions& perms,
+                       std::shared_ptr<Cell> cell,
+                       const std::function<bool(const T&)>& validate) :
+                base_property(perms, _cell_storage<T>(), cell, validate),
+                _cell(std::move(cell)) {
+            static_assert(variant_constructable<T>::value);
+        }
+
+    public:
+        explicit _cell_property(const property_permissions& perms,
+                                const T& value = T()) :
+                _cell_property(perms, std::make_shared<Cell>(value), {}) {
+        }
+
+        _cell_property(const property_permissions& perms,
+                       const std::function<bool(const T&)>& validate,
+                       const T& value = T()) :
+                _cell_property(perms, std::make_shared<Cell>(value),
+                               validate) {
+        }
+
+        operator T() const {
+            return _cell->load();
+        }
+
+        // Calls f with the value after every write, including remote ones,
+        // on the writing thread or through exec
+        [[nodiscard]] subscription subscribe(
+                std::function<void(const T&)> f,
+                executor exec = nullptr) const {
+            return _subscribe([f, exec, cell = _cell]() {
+                const T value = cell->load();
+                if (exec)
+                    exec([f, value]() { f(value); });
+                else
+                    f(value);
+            });
+        }
+
+        Derived& operator=(const T& o) {
+            _cell->store(o);
+            notify_change();
+            return static_cast<Derived&>(*this);
+        }
+
+        Derived& operator=(const _cell_property& o) {
+            if (this != &o)
+                operator=(o._cell->load());
+            return static_cast<Derived&>(*this);
+        }
+    };
+
+    template<typename T>
+    class property<T, lock_free> :
+            public _cell_property<property<T, lock_free>, T,
+                    _atomic_cell<T>> {
+    public:
+        using _cell_property<property<T, lock_free>, T,
+                _atomic_cell<T>>::_cell_property;
+        using _cell_property<property<T, lock_free>, T,
+                _atomic_cell<T>>::operator=;
+    };
+
+    template<typename T>
+    class property<T, seqlock> :
+            public _cell_property<property<T, seqlock>, T,
+                    _seqlock_cell<T>> {
+    public:
+        using _cell_property<property<T, seqlock>, T,
+                _seqlock_cell<T>>::_cell_property;
+        using _cell_property<property<T, seqlock>, T,
+                _seqlock_cell<T>>::operator=;
+    };
+
+    template<typename T>
+    class property<T, snapshot> : public base_property {
+        typedef _snapshot_cell<T> cell;
+        std::shared_ptr<cell> _cell;
+
+        property(const property_permissions& perms,
+                 std::shared_ptr<cell> c,
+                 const std::function<bool(const T&)>& validate) :
+                base_property(perms, _cell_storage<T>(), c, validate),
+                _cell(std::move(c)) {
+            static_assert(variant_constructable<T>::value);
+        }
+
+    public:
+        explicit property(const property_permissions& perms,
+                          T value = T()) :
+                property(perms, std::make_shared<cell>(
+                        std::make_shared<const T>(std::move(value))), {}) {
+        }
+
+        property(const property_permissions& perms,
+                 const std::function<bool(const T&)>& validate,
+                 T value = T()) :
+                property(perms, std::make_shared<cell>(
+                        std::make_shared<const T>(std::move(value))),
+                         validate) {
+        }
+
+        // The current version, valid for as long as it is held
+        [[nodiscard]] std::shared_ptr<const T> load() const {
+            return _cell->load();
+        }
+
+        // Calls f with the published version after every write, including
+        // remote ones, on the writing thread or through exec
+        [[nodiscard]] subscription subscribe(
+                std::function<void(const T&)> f,
+                executor exec = nullptr) const {
+            return _subscribe([deliver = _deliver(std::move(f), exec),
+                               cell = _cell]() {
+                deliver(cell->load());
+            });
+        }
+
+        void publish(std::shared_ptr<const T> value) {
+            if (!value)
+                throw std::invalid_argument("null snapshot");
+            _cell->store(std::move(value));
+            notify_change();
+        }
+
+        // Copy-modify-publish; f may run more than once under contention
+        template<typename F>
+        void update(F&& f) {
+            _cell->update(std::forward<F>(f));
+            notify_change();
+        }
+
+        property& operator=(T value) {
+            _cell->store(std::move(value));
             notify_change();
             return *this;
         }
+
+        property& operator=(const property& o) {
+            if (this != &o)
+                publish(o.load());
+            return *this;
+        }
+    };
+
+    // A property read through a getter. Reads within ttl of the last call
+    // reuse its result; without a ttl every read calls the getter, but
+    // concurrent reads still share one call. Writeable only with a setter.
+    template<typename T>
+    class computed_property : public base_property {
+        typedef _computed_cell<T> cell;
+        std::shared_ptr<cell> _cell;
+
+        computed_property(property_permissions perms,
+                          std::shared_ptr<cell> c,
+                          const std::function<bool(const T&)>& validate) :
+                base_property(perms, _cell_storage<T>(), c, validate, false),
+                _cell(std::move(c)) {
+            static_assert(variant_constructable<T>::value);
+        }
+
+    public:
+        explicit computed_property(
+                std::function<T()> getter,
+                std::chrono::steady_clock::duration ttl =
+                std::chrono::steady_clock::duration::zero()) :
+                computed_property(property_readable, std::make_shared<cell>(
+                        std::move(getter), nullptr, ttl), {}) {
+        }
+
+        computed_property(std::function<T()> getter,
+                          std::function<void(const T&)> setter,
+                          std::chrono::steady_clock::duration ttl =
+                          std::chrono::steady_clock::duration::zero(),
+                          const std::function<bool(const T&)>& validate =
+                          nullptr) :
+                computed_property(property_full_permissions,
+                                  std::make_shared<cell>(
+                                          std::move(getter),
+                                          std::move(setter), ttl),
+                                  validate) {
+        }
+
+        operator T() const {
+            return _cell->load();
+        }
+
+        // Drops the cached value and announces the change, for values that
+        // changed without going through the setter
+        void invalidate() {
+            _cell->invalidate();
+            notify_change();
+        }
+    };
+
+    // A map property that can be edited an element at a time. Edits emit
+    // <name>ElementsChanged(t sequence, a{KV} changed, aK removed) so
+    // clients can keep a replica without re-reading the map;
+    // PropertiesChanged then only invalidates it. Assigning the whole map
+    // emits no delta.
+    //
+    // Deltas are emitted right after each edit, outside the property lock,
+    // so concurrent edits may send them out of order. sequence counts the
+    // edits from 1 in the order they were applied: a client that sees it
+    // skip or go back has missed or reordered a delta and should re-read
+    // the map. Deltas are not held back by interface::transaction, and may
+    // arrive before the PropertiesChanged of their transaction.
+    template<typename K, typename V, typename Lock = std::mutex>
+    class map_property : public property<std::map<K, V>, Lock> {
+        typedef property<std::map<K, V>, Lock> base;
+
+        // Guarded by the property lock, shared by copies like the value
+        std::shared_ptr<uint64_t> _sequence = std::make_shared<uint64_t>(0);
+
+        void _init() {
+            this->_emit_deltas(signal::make_signal<
+                    uint64_t, std::map<K, V>, std::vector<K>>(
+                    {"sequence", "changed", "removed"}));
+        }
+
+        void _changed(uint64_t sequence, const std::map<K, V>& changed,
+                      const std::vector<K>& removed) {
+            this->notify_change();
+            this->notify_delta({to_variant(sequence), to_variant(changed),
+                                to_variant(removed)});
+        }
+
+    public:
+        template<typename... Args>
+        explicit map_property(const property_permissions& perms,
+                              Args... args) :
+                base(perms, std::forward<Args>(args)...) {
+            _init();
+        }
+
+        using base::operator=;
+
+        [[nodiscard]] std::optional<V> find(const K& key) const {
+            std::lock_guard<Lock> lock(*this->_lock);
+            auto it = this->_data->find(key);
+            if (it == this->_data->end())
+                return std::nullopt;
+            return it->second;
+        }
+
+        [[nodiscard]] std::size_t size() const {
+            std::lock_guard<Lock> lock(*this->_lock);
+            return this->_data->size();
+        }
+
+        void insert_or_assign(const K& key, V value) {
+            std::map<K, V> changed;
+            uint64_t sequence;
+            {
+                std::lock_guard<Lock> lock(*this->_lock);
+                this->_data->insert_or_assign(key, value);
+                sequence = ++*_sequence;
+            }
+            changed.emplace(key, std::move(value));
+            _changed(sequence, changed, {});
+        }
+
+        bool erase(const K& key) {
+            uint64_t sequence;
+            {
+                std::lock_guard<Lock> lock(*this->_lock);
+                if (!this->_data->erase(key))
+                    return false;
+                sequence = ++*_sequence;
+            }
+            _changed(sequence, {}, {key});
+            return true;
+        }
+
+        // Applies several edits under one lock with a single delta
+        void apply(const std::map<K, V>& changed,
+                   const std::vector<K>& removed) {
+            if (changed.empty() && removed.empty())
+                return;
+            uint64_t sequence;
+            {
+                std::lock_guard<Lock> lock(*this->_lock);
+                for (auto& x: changed)
+                    this->_data->insert_or_assign(x.first, x.second);
+                for (auto& x: removed)
+                    this->_data->erase(x);
+                sequence = ++*_sequence;
+            }
+            _changed(sequence, changed, removed);
+        }
     };
 }
 
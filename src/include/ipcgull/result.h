@@ -0,0 +1,182 @@
+/*
+ * Copyright 2022 PixlOne
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef IPCGULL_RESULT_H
+#define IPCGULL_RESULT_H
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <variant>
+
+namespace ipcgull {
+    // Mapped onto the matching org.freedesktop.DBus.Error.* by the backend
+    enum error_code : uint8_t {
+        error_failed,
+        error_invalid_args,
+        error_invalid_signature,
+        error_unknown_property,
+        error_property_read_only,
+        error_access_denied,
+        error_timeout,
+        error_not_supported
+    };
+
+    class call_error {
+        error_code _code;
+        std::string _name;
+        std::string _message;
+    public:
+        call_error(error_code code, std::string message);
+
+        // A typed error, sent to the caller under its own D-Bus error name
+        // (e.g. "com.example.Error.Busy")
+        call_error(std::string name, std::string message);
+
+        [[nodiscard]] error_code code() const;
+
+        // Empty unless this is a typed error
+        [[nodiscard]] const std::string& name() const;
+
+        [[nodiscard]] const std::string& message() const;
+
+        // Throws the exception the throwing API used for this error
+        [[noreturn]] void raise() const;
+    };
+
+    // Either a value or a call_error. Used on the dispatch paths so that
+    // bad input from a client is reported without unwinding.
+    template<typename T>
+    class result {
+        std::variant<T, call_error> _data;
+    public:
+        template<typename U = T, typename = std::enable_if_t<
+                std::is_constructible<T, U&&>::value &&
+                !std::is_same<std::decay_t<U>, call_error>::value &&
+                !std::is_same<std::decay_t<U>, result>::value>>
+        result(U&& value) :
+                _data(std::in_place_index<0>, std::forward<U>(value)) {
+        }
+
+        result(call_error error) :
+                _data(std::in_place_index<1>, std::move(error)) {
+        }
+
+        [[nodiscard]] bool has_value() const noexcept {
+            return _data.index() == 0;
+        }
+
+        explicit operator bool() const noexcept {
+            return has_value();
+        }
+
+        // Raises the error if there is no value
+        T& value() & {
+            if (!has_value())
+                error().raise();
+            return *std::get_if<0>(&_data);
+        }
+
+        const T& value() const& {
+            if (!has_value())
+                error().raise();
+            return *std::get_if<0>(&_data);
+        }
+
+        T&& value() && {
+            if (!has_value())
+                error().raise();
+            return std::move(*std::get_if<0>(&_data));
+        }
+
+        // Unchecked access
+        T& operator*() & {
+            return *std::get_if<0>(&_data);
+        }
+
+        const T& operator*() const& {
+            return *std::get_if<0>(&_data);
+        }
+
+        T&& operator*() && {
+            return std::move(*std::get_if<0>(&_data));
+        }
+
+        T* operator->() {
+            return std::get_if<0>(&_data);
+        }
+
+        const T* operator->() const {
+            return std::get_if<0>(&_data);
+        }
+
+        [[nodiscard]] const call_error& error() const {
+            return *std::get_if<1>(&_data);
+        }
+    };
+
+    template<>
+    class result<void> {
+        std::optional<call_error> _error;
+    public:
+        result() = default;
+
+        result(call_error error) : _error(std::move(error)) {
+        }
+
+        [[nodiscard]] bool has_value() const noexcept {
+            return !_error;
+        }
+
+        explicit operator bool() const noexcept {
+            return has_value();
+        }
+
+        void value() const {
+            if (_error)
+                _error->raise();
+        }
+
+        [[nodiscard]] const call_error& error() const {
+            return *_error;
+        }
+    };
+
+    template<typename T>
+    struct is_result : std::false_type {
+    };
+
+    template<typename T>
+    struct is_result<result<T>> : std::true_type {
+    };
+
+    // The type a handler returning R hands back on success
+    template<typename T>
+    struct result_value {
+        typedef T type;
+    };
+
+    template<typename T>
+    struct result_value<result<T>> {
+        typedef T type;
+    };
+}
+
+#endif //IPCGULL_RESULT_H
@@ -19,10 +19,14 @@
 #ifndef IPCGULL_SERVER_H
 #define IPCGULL_SERVER_H
 
+#include <chrono>
 #include <memory>
 #include <mutex>
 #include <ipcgull/variant.h>
 #include <ipcgull/connection.h>
+#include <ipcgull/observer.h>
+#include <ipcgull/stats.h>
+#include <ipcgull/signal.h>
 
 namespace ipcgull {
     class node;
@@ -44,8 +48,9 @@ namespace ipcgull {
         // Only the node should access these functions
         void emit_signal(
                 const std::string& node, const std::string& iface,
-                const std::string& signal, const variant_tuple& args,
-                const variant_type& args_type) const;
+                const std::string& signal, const signal_payload& payload,
+                const signal_policy& policy,
+                const std::vector<std::string>& destinations) const;
 
         void add_interface(const std::shared_ptr<node>& node,
                            const interface& iface);
@@ -53,6 +58,11 @@ namespace ipcgull {
         bool drop_interface(const std::string& node_path,
                             const std::string& if_name) noexcept;
 
+        // Queues the property for the next PropertiesChanged signal
+        void property_changed(const std::string& node,
+                              const std::string& iface,
+                              const std::string& property);
+
         void set_managing(const std::shared_ptr<node>& n,
                           const std::weak_ptr<object>& managing);
 
@@ -85,6 +95,34 @@ namespace ipcgull {
         [[nodiscard]] bool running() const;
 
         [[nodiscard]] const std::string& root_node() const;
+
+        // Receives spans around each dispatch phase, signal emission and
+        // object registration. Pass nullptr to remove it.
+        void set_observer(std::shared_ptr<observer> o);
+
+        [[nodiscard]] server_stats stats() const;
+
+        // Registers org.ipcgull.Stats on the root node path, exposing
+        // stats() as read-only properties.
+        void export_stats(bool exported = true);
+
+        // Dispatch latency of every member called so far
+        [[nodiscard]] latency_report latency() const;
+
+        void reset_latency();
+
+        // PropertiesChanged signals are coalesced per interface. With a
+        // zero window (the default) they are sent once per main loop
+        // iteration, otherwise at most once per window.
+        void set_properties_changed_window(std::chrono::milliseconds window);
+
+        // With a non-zero capacity, emitting a signal only queues it and
+        // the main loop marshals and sends it, so emitters never wait on
+        // the server lock. What happens when the queue is full is set per
+        // signal (signal_policy::overflow). If the main loop is not
+        // running, blocked emitters send the queued signals themselves.
+        // Zero (the default) sends signals synchronously.
+        void set_signal_queue(std::size_t capacity);
     };
 
     [[maybe_unused]]
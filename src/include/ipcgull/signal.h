@@ -19,10 +19,47 @@
 #ifndef IPCGULL_SIGNAL_H
 #define IPCGULL_SIGNAL_H
 
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
 #include <vector>
+#include <ipcgull/variant.h>
 
 namespace ipcgull {
-    class variant_type;
+    template<typename... Args>
+    struct typed_signal;
+
+    // What emitting does when the server's signal queue is full, see
+    // server::set_signal_queue()
+    enum signal_overflow : uint8_t {
+        // Wait for the main loop to make room
+        overflow_block,
+        // Discard the oldest queued signal
+        overflow_drop_oldest,
+        // Discard the signal being emitted
+        overflow_drop_newest
+    };
+
+    struct signal_policy {
+        signal_overflow overflow = overflow_block;
+        // Emissions closer than this to the last one sent are dropped, or
+        // held back if coalesce_latest is set. Dropped emissions are gone
+        // for good, so without coalesce_latest the final value of a burst
+        // may never be sent: use coalesce_latest for state updates.
+        std::chrono::steady_clock::duration min_interval{0};
+        // Keep only the latest held-back args and send them once
+        // min_interval has passed (or on the next main loop iteration)
+        bool coalesce_latest = false;
+
+        [[nodiscard]] bool throttled() const {
+            return coalesce_latest ||
+                   min_interval > std::chrono::steady_clock::duration::zero();
+        }
+    };
 
     struct signal {
     private:
@@ -32,18 +69,123 @@ namespace ipcgull {
     public:
         const std::vector<variant_type> types;
         const std::vector<std::string> names;
+        // variant_type::tuple(types)
+        const variant_type args_type;
+        signal_policy policy;
+
+        [[nodiscard]] signal with_policy(const signal_policy& p) const {
+            signal ret = *this;
+            ret.policy = p;
+            return ret;
+        }
+
+        [[nodiscard]] signal with_overflow(signal_overflow overflow) const {
+            signal ret = *this;
+            ret.policy.overflow = overflow;
+            return ret;
+        }
+
+        [[nodiscard]] signal with_min_interval(
+                std::chrono::steady_clock::duration interval) const {
+            signal ret = *this;
+            ret.policy.min_interval = interval;
+            return ret;
+        }
+
+        // per_second must be positive
+        [[nodiscard]] signal with_max_rate(double per_second) const {
+            if (!(per_second > 0))
+                throw std::invalid_argument("signal rate must be positive");
+
+            typedef std::chrono::steady_clock::duration duration;
+            const std::chrono::duration<double> interval(1 / per_second);
+            if (interval >= duration::max())
+                return with_min_interval(duration::max());
+            return with_min_interval(
+                    std::chrono::duration_cast<duration>(interval));
+        }
+
+        [[nodiscard]] signal with_coalesce_latest(bool coalesce = true) const {
+            signal ret = *this;
+            ret.policy.coalesce_latest = coalesce;
+            return ret;
+        }
 
         template<typename... Args>
-        static signal make_signal(
-                const std::array<std::string, sizeof...(Args)>& n) {
-            return {{make_variant_type<Args>()...},
-                    {n.begin(), n.end()}};
+        static typed_signal<Args...> make_signal(
+                const std::array<std::string, sizeof...(Args)>& n);
+    };
+
+    // A signal that remembers its argument types, so that
+    // interface::bind_signal can deduce them
+    template<typename... Args>
+    struct typed_signal : public signal {
+        explicit typed_signal(signal s) : signal(std::move(s)) {}
+
+        [[nodiscard]] typed_signal with_policy(const signal_policy& p) const {
+            return typed_signal(signal::with_policy(p));
+        }
+
+        [[nodiscard]] typed_signal with_overflow(
+                signal_overflow overflow) const {
+            return typed_signal(signal::with_overflow(overflow));
+        }
+
+        [[nodiscard]] typed_signal with_min_interval(
+                std::chrono::steady_clock::duration interval) const {
+            return typed_signal(signal::with_min_interval(interval));
+        }
+
+        [[nodiscard]] typed_signal with_max_rate(double per_second) const {
+            return typed_signal(signal::with_max_rate(per_second));
+        }
+
+        [[nodiscard]] typed_signal with_coalesce_latest(
+                bool coalesce = true) const {
+            return typed_signal(signal::with_coalesce_latest(coalesce));
         }
     };
 
+    template<typename... Args>
+    typed_signal<Args...> signal::make_signal(
+            const std::array<std::string, sizeof...(Args)>& n) {
+        return typed_signal<Args...>(
+                signal({make_variant_type<Args>()...},
+                       {n.begin(), n.end()}));
+    }
+
     template<typename... Args>
     [[maybe_unused]]
     const auto make_signal = signal::make_signal<Args...>;
+
+    // Signal arguments that are marshalled at most once, no matter how many
+    // objects or servers they are emitted from (see
+    // interface::emit_payload). Arguments referring to objects are
+    // marshalled again for each server, since object paths differ. Copies
+    // share the same arguments.
+    class signal_payload {
+    public:
+        // Implementation-defined
+        struct internal;
+    private:
+        std::shared_ptr<internal> _internal;
+    public:
+        // args_type must be the tuple of the arguments' types
+        signal_payload(variant_tuple args, variant_type args_type);
+
+        template<typename... Args>
+        [[nodiscard]] static signal_payload make(Args... args) {
+            return {std::vector<variant>{to_variant(args)...},
+                    variant_type::tuple(std::vector<variant_type>{
+                            make_variant_type<Args>()...})};
+        }
+
+        [[nodiscard]] const variant_tuple& args() const;
+
+        [[nodiscard]] const variant_type& type() const;
+
+        [[nodiscard]] internal& raw_data() const;
+    };
 }
 
 #endif //IPCGULL_SIGNAL_H
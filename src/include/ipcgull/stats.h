@@ -0,0 +1,144 @@
+/*
+ * Copyright 2022 PixlOne
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef IPCGULL_STATS_H
+#define IPCGULL_STATS_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace ipcgull {
+    enum dispatch_phase : uint8_t {
+        phase_decode,
+        phase_handler,
+        phase_encode,
+        phase_reply,
+        phase_count
+    };
+
+    enum call_kind : uint8_t {
+        call_method,
+        call_get_property,
+        call_set_property
+    };
+
+    struct histogram_snapshot {
+        // Indexed like latency_histogram buckets
+        std::vector<uint64_t> buckets;
+        uint64_t count = 0;
+        std::chrono::nanoseconds total{0};
+        std::chrono::nanoseconds max{0};
+
+        [[nodiscard]] std::chrono::nanoseconds mean() const;
+
+        // Lower bound of the bucket holding the p-th percentile (0-100)
+        [[nodiscard]] std::chrono::nanoseconds percentile(double p) const;
+    };
+
+    // HDR-style log histogram of nanosecond durations. Each power of two
+    // is split into 2^sub_bucket_bits linear buckets, so the relative
+    // error stays under 25%. Recording is wait-free.
+    class latency_histogram {
+    public:
+        static constexpr std::size_t sub_bucket_bits = 2;
+        // Durations of 2^magnitude_count ns (~18 minutes) or more are
+        // clamped into the last bucket.
+        static constexpr std::size_t magnitude_count = 40;
+        static constexpr std::size_t bucket_count =
+                (magnitude_count - sub_bucket_bits + 1) << sub_bucket_bits;
+    private:
+        std::array<std::atomic<uint64_t>, bucket_count> _buckets{};
+        std::atomic<uint64_t> _count{0};
+        std::atomic<uint64_t> _total{0};
+        std::atomic<uint64_t> _max{0};
+    public:
+        latency_histogram() = default;
+
+        latency_histogram(const latency_histogram&) = delete;
+
+        void record(std::chrono::nanoseconds duration) noexcept;
+
+        [[nodiscard]] histogram_snapshot snapshot() const;
+
+        void reset() noexcept;
+
+        [[nodiscard]] static std::size_t bucket_index(uint64_t ns) noexcept;
+
+        [[nodiscard]] static uint64_t bucket_floor(std::size_t index) noexcept;
+    };
+
+    // Latency of one interface member, split by dispatch phase
+    class call_latency {
+        std::array<latency_histogram, phase_count> _phases;
+    public:
+        typedef std::array<histogram_snapshot, phase_count> snapshot_type;
+
+        latency_histogram& operator[](dispatch_phase phase);
+
+        const latency_histogram& operator[](dispatch_phase phase) const;
+
+        // Records the time elapsed since `since` and restarts it
+        void record(dispatch_phase phase,
+                    std::chrono::steady_clock::time_point& since) noexcept;
+
+        [[nodiscard]] snapshot_type snapshot() const;
+
+        void reset() noexcept;
+    };
+
+    struct latency_key {
+        call_kind kind;
+        std::string interface;
+        // Empty for GetAll
+        std::string member;
+
+        bool operator<(const latency_key& o) const;
+    };
+
+    typedef std::map<latency_key, call_latency::snapshot_type> latency_report;
+
+    struct server_stats {
+        uint64_t method_calls = 0;
+        uint64_t property_gets = 0;
+        uint64_t property_sets = 0;
+        uint64_t errors = 0;
+        uint64_t bytes_in = 0;
+        uint64_t bytes_out = 0;
+        uint64_t signals_emitted = 0;
+        // Discarded by a full signal queue or a signal's min_interval
+        uint64_t signals_dropped = 0;
+        // Replaced by newer args while held back by coalesce_latest
+        uint64_t signals_coalesced = 0;
+        // Signals emitted during the last whole second
+        uint64_t signal_rate = 0;
+        // Calls currently being dispatched
+        uint64_t pending_calls = 0;
+        // Time spent waiting for the server lock on the hot paths
+        std::chrono::nanoseconds lock_wait_total{0};
+        std::chrono::nanoseconds lock_wait_max{0};
+        uint64_t objects = 0;
+        uint64_t interfaces = 0;
+    };
+}
+
+#endif //IPCGULL_STATS_H
@@ -0,0 +1,132 @@
+/*
+ * Copyright 2022 PixlOne
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef IPCGULL_TABLE_H
+#define IPCGULL_TABLE_H
+
+#include <algorithm>
+#include <initializer_list>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace ipcgull {
+    // Immutable name -> V table, stored as a sorted array. Lookups take a
+    // std::string_view so callers can search with a C string without
+    // allocating. Iteration is in key order, like the std::map it replaces.
+    template<typename V>
+    class frozen_table {
+    public:
+        typedef std::string key_type;
+        typedef V mapped_type;
+        typedef std::pair<const std::string, V> value_type;
+        typedef typename std::vector<value_type>::iterator iterator;
+        typedef typename std::vector<value_type>::const_iterator
+                const_iterator;
+    private:
+        std::vector<value_type> _entries;
+
+        template<typename It>
+        static It _lower_bound(It begin, It end, std::string_view key) {
+            return std::lower_bound(
+                    begin, end, key,
+                    [](const value_type& entry, std::string_view k) {
+                        return std::string_view(entry.first) < k;
+                    });
+        }
+
+    public:
+        frozen_table() = default;
+
+        // Duplicate names keep the first entry, as with std::map
+        frozen_table(std::initializer_list<value_type> entries) :
+                frozen_table(std::map<std::string, V>(entries.begin(),
+                                                      entries.end())) {
+        }
+
+        frozen_table(std::map<std::string, V> entries) {
+            _entries.reserve(entries.size());
+            while (!entries.empty()) {
+                auto node = entries.extract(entries.begin());
+                _entries.emplace_back(std::move(node.key()),
+                                      std::move(node.mapped()));
+            }
+        }
+
+        [[nodiscard]] const_iterator find(std::string_view key) const {
+            auto it = _lower_bound(_entries.begin(), _entries.end(), key);
+            if (it == _entries.end() || it->first != key)
+                return _entries.end();
+            return it;
+        }
+
+        [[nodiscard]] iterator find(std::string_view key) {
+            auto it = _lower_bound(_entries.begin(), _entries.end(), key);
+            if (it == _entries.end() || it->first != key)
+                return _entries.end();
+            return it;
+        }
+
+        [[nodiscard]] const V& at(std::string_view key) const {
+            auto it = find(key);
+            if (it == end())
+                throw std::out_of_range("frozen_table::at");
+            return it->second;
+        }
+
+        [[nodiscard]] V& at(std::string_view key) {
+            auto it = find(key);
+            if (it == end())
+                throw std::out_of_range("frozen_table::at");
+            return it->second;
+        }
+
+        [[nodiscard]] std::size_t count(std::string_view key) const {
+            return find(key) == end() ? 0 : 1;
+        }
+
+        [[nodiscard]] std::size_t size() const {
+            return _entries.size();
+        }
+
+        [[nodiscard]] bool empty() const {
+            return _entries.empty();
+        }
+
+        [[nodiscard]] const_iterator begin() const {
+            return _entries.begin();
+        }
+
+        [[nodiscard]] const_iterator end() const {
+            return _entries.end();
+        }
+
+        [[nodiscard]] iterator begin() {
+            return _entries.begin();
+        }
+
+        [[nodiscard]] iterator end() {
+            return _entries.end();
+        }
+    };
+}
+
+#endif //IPCGULL_TABLE_H
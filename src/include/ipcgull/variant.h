@@ -26,6 +26,7 @@
 #include <string>
 #include <variant>
 #include <vector>
+#include <ipcgull/result.h>
 
 namespace ipcgull {
     class object {
@@ -173,8 +174,17 @@ namespace ipcgull {
     struct variant_constructable<const T> : variant_constructable<T> {
     };
 
+    // try_get leaves `out` unspecified when it returns false
     template<typename T>
     struct _variant_helper {
+        static bool try_get(const variant& v, T& out) {
+            if (const auto* x = std::get_if<T>(&v)) {
+                out = *x;
+                return true;
+            }
+            return false;
+        }
+
         static T get(const variant& v) {
             return std::get<T>(v);
         }
@@ -186,11 +196,25 @@ namespace ipcgull {
 
     template<typename T>
     struct _variant_helper<std::vector<T>> {
+        static bool try_get(const variant& v, std::vector<T>& out) {
+            const auto* vec = std::get_if<std::vector<variant>>(&v);
+            if (!vec)
+                return false;
+            out.resize(vec->size());
+            for (std::size_t i = 0; i < vec->size(); ++i) {
+                T element;
+                if (!_variant_helper<T>::try_get((*vec)[i], element))
+                    return false;
+                out[i] = std::move(element);
+            }
+
+            return true;
+        }
+
         static std::vector<T> get(const variant& v) {
-            const auto& vec = std::get<std::vector<variant>>(v);
-            std::vector<T> ret(vec.size());
-            for (std::size_t i = 0; i < vec.size(); ++i)
-                ret[i] = _variant_helper<T>::get(vec[i]);
+            std::vector<T> ret;
+            if (!try_get(v, ret))
+                throw std::bad_variant_access();
 
             return ret;
         }
@@ -209,11 +233,10 @@ namespace ipcgull {
     struct _variant_helper<std::tuple<Args...>> {
     private:
         template<std::size_t... S>
-        static std::tuple<Args...> get(const variant_tuple& v,
-                                       std::index_sequence<S...>) {
-            return std::make_tuple<Args...>(
-                    _variant_helper<typename std::tuple_element<S,
-                            std::tuple<Args...> >::type>::get(v[S])...);
+        static bool try_get(const variant_tuple& v, std::tuple<Args...>& out,
+                            std::index_sequence<S...>) {
+            return (_variant_helper<Args>::try_get(v[S], std::get<S>(out)) &&
+                    ...);
         }
 
         template<std::size_t... S>
@@ -225,12 +248,26 @@ namespace ipcgull {
         }
 
     public:
+        // Decodes method arguments without copying them into a variant
+        static bool try_get(const variant_tuple& v, std::tuple<Args...>& out) {
+            if (v.size() != sizeof...(Args))
+                return false;
+
+            return try_get(v, out,
+                           std::make_index_sequence<sizeof...(Args)>());
+        }
+
+        static bool try_get(const variant& v, std::tuple<Args...>& out) {
+            const auto* vec = std::get_if<variant_tuple>(&v);
+            return vec && try_get(*vec, out);
+        }
+
         static std::tuple<Args...> get(const variant& v) {
-            const auto& vec = std::get<variant_tuple>(v);
-            if (vec.size() != sizeof...(Args))
+            std::tuple<Args...> ret;
+            if (!try_get(v, ret))
                 throw std::bad_variant_access();
 
-            return get(vec, std::make_index_sequence<sizeof...(Args)>());
+            return ret;
         }
 
         static variant make(const std::tuple<Args...>& x) {
@@ -240,28 +277,39 @@ namespace ipcgull {
 
     template<typename K, typename V>
     struct _variant_helper<std::map<K, V>> {
+        static bool try_get(const variant& v, std::map<K, V>& out) {
+            const auto* m = std::get_if<std::map<variant, variant>>(&v);
+            if (!m)
+                return false;
+            out.clear();
+            for (const auto& i: *m) {
+                K key;
+                V value;
+                if (!_variant_helper<K>::try_get(i.first, key) ||
+                    !_variant_helper<V>::try_get(i.second, value))
+                    return false;
+                out.emplace_hint(out.end(), std::move(key), std::move(value));
+            }
+
+            return true;
+        }
+
         static std::map<K, V> get(const variant& v) {
             std::map<K, V> ret;
-            const auto& m = std::get<std::map<K, variant>>(v);
-            for (const auto& i: m)
-                ret.emplace(std::piecewise_construct,
-                            std::forward_as_tuple(
-                                    _variant_helper<K>::get(i.first)),
-                            std::forward_as_tuple(
-                                    _variant_helper<V>::get(i.second)));
+            if (!try_get(v, ret))
+                throw std::bad_variant_access();
 
             return ret;
         }
 
         static variant make(const std::map<K, V>& v) {
             std::map<variant, variant> ret;
-            const auto& m = std::get<std::map<K, variant>>(v);
-            for (const auto& i: m)
+            for (const auto& i: v)
                 ret.emplace(std::piecewise_construct,
                             std::forward_as_tuple(
                                     _variant_helper<K>::make(i.first)),
                             std::forward_as_tuple(
-                                    _variant_helper<K>::make(i.second)));
+                                    _variant_helper<V>::make(i.second)));
 
             return ret;
         }
@@ -269,6 +317,16 @@ namespace ipcgull {
 
     template<typename T>
     struct _variant_helper<std::shared_ptr<T>> {
+        static bool try_get(const variant& v, std::shared_ptr<T>& out) {
+            static_assert(std::is_base_of<object, T>::value,
+                          "T must be an ipcgull::object");
+            const auto* obj = std::get_if<std::shared_ptr<object>>(&v);
+            if (!obj)
+                return false;
+            out = std::dynamic_pointer_cast<T>(*obj);
+            return true;
+        }
+
         static std::shared_ptr<T> get(const variant& v) {
             static_assert(std::is_base_of<object, T>::value,
                           "T must be an ipcgull::object");
@@ -323,6 +381,18 @@ namespace ipcgull {
         return _variant_helper<typename _normalize_type<T>::type>::get(v);
     }
 
+    // Reports a type mismatch as error_invalid_signature instead of throwing
+    template<typename T>
+    result<typename _normalize_type<T>::type> try_from_variant(
+            const variant& v) {
+        typedef typename _normalize_type<T>::type type;
+        type ret{};
+        if (!_variant_helper<type>::try_get(v, ret))
+            return call_error(error_invalid_signature,
+                              "Invalid argument type");
+        return ret;
+    }
+
     template<typename T>
     variant to_variant(const T& t) {
         static_assert(variant_constructable<T>::value);
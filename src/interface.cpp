@@ -16,6 +16,10 @@
  *
  */
 
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <random>
 #include <stdexcept>
 #include <utility>
 #include <ipcgull/variant.h>
@@ -25,6 +29,44 @@
 
 using namespace ipcgull;
 
+namespace {
+    // Innermost open transaction on this thread
+    thread_local interface::transaction* current_transaction = nullptr;
+
+    constexpr const char* delta_signal_suffix = "ElementsChanged";
+
+    uint64_t new_generation() {
+        static const uint64_t base = []() {
+            std::random_device rd;
+            const auto now = static_cast<uint64_t>(
+                    std::chrono::system_clock::now().time_since_epoch()
+                            .count());
+            return ((uint64_t(rd()) << 32) | rd()) ^ now;
+        }();
+        static std::atomic<uint64_t> next{0};
+
+        const auto generation = base + next.fetch_add(
+                1, std::memory_order_relaxed);
+        return generation ? generation : 1;
+    }
+
+    // Declares the delta signals of container properties
+    interface::signal_table with_delta_signals(
+            interface::signal_table signals,
+            const interface::property_table& properties) {
+        if (std::none_of(properties.begin(), properties.end(),
+                         [](auto& x) { return x.second.delta_signal(); }))
+            return signals;
+
+        std::map<std::string, signal> merged(signals.begin(), signals.end());
+        for (auto& x: properties) {
+            if (auto& delta = x.second.delta_signal())
+                merged.emplace(x.first + delta_signal_suffix, *delta);
+        }
+        return interface::signal_table(std::move(merged));
+    }
+}
+
 interface::interface(std::string name,
                      function_table f,
                      property_table p,
@@ -32,7 +74,9 @@ interface::interface(std::string name,
         _name(std::move(name)),
         _functions(std::move(f)),
         _properties(std::move(p)),
-        _signals(std::move(s)) {
+        _signals(with_delta_signals(std::move(s), _properties)),
+        _generation(new_generation()),
+        _changed_at(new std::atomic<uint64_t>[_properties.size()]()) {
 }
 
 interface::interface(std::string name,
@@ -40,7 +84,10 @@ interface::interface(std::string name,
         _name(std::move(name)),
         _functions(std::move(std::get<0>(t))),
         _properties(std::move(std::get<1>(t))),
-        _signals(std::move(std::get<2>(t))) {
+        _signals(with_delta_signals(std::move(std::get<2>(t)),
+                                    _properties)),
+        _generation(new_generation()),
+        _changed_at(new std::atomic<uint64_t>[_properties.size()]()) {
 }
 
 interface::~interface() {
@@ -50,12 +97,16 @@ interface::~interface() {
 
 interface::interface(interface&& o) noexcept:
         _name(o._name), _functions(o._functions),
-        _properties(o._properties), _signals(o._signals) {
+        _properties(o._properties), _signals(o._signals),
+        _generation(new_generation()),
+        _changed_at(new std::atomic<uint64_t>[_properties.size()]()) {
 }
 
 interface::interface(const interface& o) :
         _name(o._name), _functions(o._functions),
-        _properties(o._properties), _signals(o._signals) {
+        _properties(o._properties), _signals(o._signals),
+        _generation(new_generation()),
+        _changed_at(new std::atomic<uint64_t>[_properties.size()]()) {
 }
 
 const interface::function_table& interface::functions() const {
@@ -74,17 +125,209 @@ base_property& interface::get_property(const std::string& name) {
     return _properties.at(name);
 }
 
+const base_property* interface::find_property(std::string_view name) const {
+    auto it = _properties.find(name);
+    return it == _properties.end() ? nullptr : &it->second;
+}
+
+base_property* interface::find_property(std::string_view name) {
+    auto it = _properties.find(name);
+    return it == _properties.end() ? nullptr : &it->second;
+}
+
+std::vector<interface::property_value> interface::read_properties(
+        const std::function<bool(const std::string&,
+                                 const base_property&)>& filter) const {
+    const std::shared_lock<std::shared_mutex> transaction(_transaction_lock);
+    std::vector<const property_table::value_type*> readable;
+    readable.reserve(_properties.size());
+    for (auto& x: _properties) {
+        if ((x.second.permissions() & property_readable) &&
+            (!filter || filter(x.first, x.second)))
+            readable.push_back(&x);
+    }
+    std::stable_sort(readable.begin(), readable.end(),
+                     [](auto* a, auto* b) {
+                         return std::less<const void*>()(
+                                 a->second._lock_id, b->second._lock_id);
+                     });
+
+    struct lock_guard {
+        const base_property& p;
+
+        explicit lock_guard(const base_property& x) : p(x) {
+            p._lock_op(true);
+        }
+
+        ~lock_guard() {
+            p._lock_op(false);
+        }
+    };
+
+    std::vector<property_value> ret;
+    ret.reserve(readable.size());
+    for (std::size_t i = 0; i < readable.size();) {
+        const void* lock_id = readable[i]->second._lock_id;
+        const lock_guard guard(readable[i]->second);
+        for (; i < readable.size() &&
+               readable[i]->second._lock_id == lock_id; ++i) {
+            auto& x = *readable[i];
+            const auto version = x.second.version();
+            ret.push_back({&x.first, &x.second, version,
+                           x.second._get_unlocked()});
+        }
+    }
+
+    return ret;
+}
+
 const interface::signal_table& interface::signals() const {
     return _signals;
 }
 
-void interface::_emit_signal(const std::string& signal,
-                             const std::vector<variant>& args,
-                             const variant_type& args_type) const {
+void interface::_listen_properties(
+        const std::weak_ptr<const interface>& self) const {
+    for (auto& x: _properties)
+        x.second._listen(self, x.first);
+}
+
+void interface::_unlisten_properties() const {
+    for (auto& x: _properties)
+        x.second._unlisten(this);
+}
+
+void interface::_property_changed(const std::string& property) const {
+    // Recorded at write time, even inside a transaction: a reader blocked
+    // by it then returns the new value with a newer version, never stale
+    auto it = _properties.find(property);
+    if (it != _properties.end()) {
+        const auto version = _properties_version.fetch_add(
+                1, std::memory_order_acq_rel) + 1;
+        _changed_at[it - _properties.begin()].store(
+                version, std::memory_order_release);
+    }
+
+    for (auto* t = current_transaction; t; t = t->_previous) {
+        if (t->_iface == this && t->_lock) {
+            t->_changed.insert(property);
+            return;
+        }
+    }
+
+    _announce_change(property);
+}
+
+void interface::_announce_change(const std::string& property) const {
     if (auto owner = _owner.lock())
-        owner->emit_signal(name(), signal, args, args_type);
+        owner->properties_changed(name(), property);
+}
+
+void interface::_property_delta(const std::string& property,
+                                const std::vector<variant>& args,
+                                const signal& delta_signal) const {
+    _emit_signal(property + delta_signal_suffix, args,
+                 delta_signal.args_type);
+}
+
+void interface::_emit_signal(
+        const std::string& signal,
+        const std::vector<variant>& args,
+        const variant_type& args_type) const {
+    auto it = _signals.find(signal);
+    _emit_payload(signal, it == _signals.end() ? signal_policy() :
+                          it->second.policy,
+                  signal_payload(args, args_type), {});
+}
+
+void interface::_emit_payload(
+        const std::string& signal,
+        const signal_policy& policy,
+        const signal_payload& payload,
+        const std::vector<std::string>& destinations) const {
+    if (auto owner = _owner.lock())
+        owner->emit_signal(name(), signal, payload, policy, destinations);
+}
+
+void interface::_emit_payload(
+        const std::string& signal,
+        const signal_payload& payload,
+        const std::vector<std::string>& destinations) const {
+    auto it = _signals.find(signal);
+    if (it == _signals.end())
+        throw std::runtime_error("unknown ipc signal emitted");
+    if (!(payload.type() == it->second.args_type))
+        throw std::runtime_error("invalid ipc signal arg type");
+
+    _emit_payload(signal, it->second.policy, payload, destinations);
+}
+
+void interface::emit_payload(const std::string& signal,
+                             const signal_payload& payload) const {
+    _emit_payload(signal, payload, {});
+}
+
+void interface::emit_payload_to(const std::string& destination,
+                                const std::string& signal,
+                                const signal_payload& payload) const {
+    if (destination.empty())
+        throw std::invalid_argument("empty signal destination");
+    _emit_payload(signal, payload, {destination});
+}
+
+void interface::emit_payload_to(const std::vector<std::string>& destinations,
+                                const std::string& signal,
+                                const signal_payload& payload) const {
+    if (destinations.empty())
+        return;
+    _emit_payload(signal, payload, destinations);
 }
 
 const std::string& interface::name() const {
     return _name;
 }
+
+uint64_t interface::properties_version() const {
+    return _properties_version.load(std::memory_order_acquire);
+}
+
+uint64_t interface::generation() const {
+    return _generation;
+}
+
+uint64_t interface::property_changed_at(std::string_view property) const {
+    auto it = _properties.find(property);
+    if (it == _properties.end())
+        return 0;
+    return _changed_at[it - _properties.begin()].load(
+            std::memory_order_acquire);
+}
+
+interface::transaction::transaction(const interface& iface) :
+        _iface(&iface), _lock(iface._transaction_lock, std::defer_lock),
+        _previous(current_transaction) {
+    // A nested transaction on the same interface joins the outer one
+    bool nested = false;
+    for (auto* t = _previous; t && !nested; t = t->_previous)
+        nested = t->_iface == _iface && t->_lock;
+    if (!nested)
+        _lock.lock();
+    current_transaction = this;
+}
+
+interface::transaction::~transaction() {
+    commit();
+    // Transactions are scoped, so this is the innermost one
+    assert(current_transaction == this);
+    current_transaction = _previous;
+}
+
+void interface::transaction::commit() {
+    if (!_lock)
+        return;
+    _lock.unlock();
+
+    std::set<std::string> changed;
+    changed.swap(_changed);
+    for (auto& x: changed)
+        _iface->_announce_change(x);
+}
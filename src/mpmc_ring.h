@@ -0,0 +1,115 @@
+/*
+ * Copyright 2022 PixlOne
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#ifndef IPCGULL_MPMC_RING_H
+#define IPCGULL_MPMC_RING_H
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <utility>
+
+namespace ipcgull {
+    // Bounded lock-free queue (Vyukov). Any thread may push or pop, which
+    // lets producers discard the oldest entry when it is full.
+    template<typename T>
+    class mpmc_ring {
+        struct cell {
+            std::atomic<std::size_t> sequence;
+            T data;
+        };
+
+        static constexpr std::size_t cache_line = 64;
+
+        std::unique_ptr<cell[]> _cells;
+        const std::size_t _mask;
+        alignas(cache_line) std::atomic<std::size_t> _enqueue{0};
+        alignas(cache_line) std::atomic<std::size_t> _dequeue{0};
+
+        static std::size_t _round_up(std::size_t capacity) {
+            std::size_t ret = 2;
+            while (ret < capacity)
+                ret <<= 1;
+            return ret;
+        }
+
+    public:
+        // Capacity is rounded up to a power of two
+        explicit mpmc_ring(std::size_t capacity) :
+                _cells(new cell[_round_up(capacity)]),
+                _mask(_round_up(capacity) - 1) {
+            for (std::size_t i = 0; i <= _mask; ++i)
+                _cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+
+        mpmc_ring(const mpmc_ring&) = delete;
+
+        [[nodiscard]] std::size_t capacity() const {
+            return _mask + 1;
+        }
+
+        // Moves from value only on success
+        bool try_push(T& value) {
+            auto pos = _enqueue.load(std::memory_order_relaxed);
+            for (;;) {
+                auto& c = _cells[pos & _mask];
+                const auto seq = c.sequence.load(std::memory_order_acquire);
+                const auto diff = static_cast<std::ptrdiff_t>(seq) -
+                                  static_cast<std::ptrdiff_t>(pos);
+                if (diff == 0) {
+                    if (_enqueue.compare_exchange_weak(
+                            pos, pos + 1, std::memory_order_relaxed)) {
+                        c.data = std::move(value);
+                        c.sequence.store(pos + 1, std::memory_order_release);
+                        return true;
+                    }
+                } else if (diff < 0) {
+                    return false;
+                } else {
+                    pos = _enqueue.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        bool try_pop(T& out) {
+            auto pos = _dequeue.load(std::memory_order_relaxed);
+            for (;;) {
+                auto& c = _cells[pos & _mask];
+                const auto seq = c.sequence.load(std::memory_order_acquire);
+                const auto diff = static_cast<std::ptrdiff_t>(seq) -
+                                  static_cast<std::ptrdiff_t>(pos + 1);
+                if (diff == 0) {
+                    if (_dequeue.compare_exchange_weak(
+                            pos, pos + 1, std::memory_order_relaxed)) {
+                        out = std::move(c.data);
+                        c.sequence.store(pos + _mask + 1,
+                                         std::memory_order_release);
+                        return true;
+                    }
+                } else if (diff < 0) {
+                    return false;
+                } else {
+                    pos = _dequeue.load(std::memory_order_relaxed);
+                }
+            }
+        }
+    };
+}
+
+#endif //IPCGULL_MPMC_RING_H
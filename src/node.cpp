@@ -22,6 +22,8 @@
 #include <ipcgull/node.h>
 #include <ipcgull/interface.h>
 
+#include "probes.h"
+
 using namespace ipcgull;
 
 namespace ipcgull {
@@ -35,13 +37,14 @@ namespace ipcgull {
     };
 }
 
-node::node(std::string name) : _name(std::move(name)),
+node::node(std::string name) : _name(std::move(name)), _tree_name(_name),
                                _hierarchy_lock(std::make_shared<std::recursive_mutex>()) {}
 
 node::node(std::string name,
            const std::shared_ptr<const node>& parent) :
-        _name(std::move(name)), _hierarchy_lock(parent->_hierarchy_lock),
-        _parent(parent) {}
+        _name(std::move(name)),
+        _tree_name(parent->_tree_name + "/" + _name),
+        _hierarchy_lock(parent->_hierarchy_lock), _parent(parent) {}
 
 node::~node() {
     std::lock_guard<std::recursive_mutex> lock(*_hierarchy_lock);
@@ -52,7 +55,7 @@ node::~node() {
     }
 
     for (auto& s: _servers)
-        drop_server(s);
+        drop_server(s.ptr);
 
     // Orphans are moved to the parent
     for (auto& x: _children) {
@@ -84,8 +87,8 @@ std::shared_ptr<node> node::make_child(const std::string& name) const {
     ptr->_self = ptr;
 
     for (auto& s: _servers) {
-        if (!s.expired())
-            ptr->add_server(s);
+        if (!s.ptr.expired())
+            ptr->add_server(s.ptr);
     }
 
     _children.push_front(ptr);
@@ -94,17 +97,54 @@ std::shared_ptr<node> node::make_child(const std::string& name) const {
     return ptr;
 }
 
+void node::_add_interface(const std::shared_ptr<interface>& ptr) {
+    if (_interfaces.count(ptr->name()))
+        throw std::invalid_argument("duplicate interface");
+
+    assert(!_self.expired());
+
+    IPCGULL_PROBE2(node__add__interface, _name.c_str(), ptr->name().c_str());
+
+    {
+        std::list<server_path> added_servers;
+        try {
+            for (auto& s: _servers) {
+                if (auto server = s.ptr.lock()) {
+                    server->add_interface(_self.lock(), *ptr);
+                    added_servers.push_front(s);
+                }
+            }
+        } catch (std::exception& e) {
+            while (!added_servers.empty()) {
+                auto& s = added_servers.front();
+                if (auto server = s.ptr.lock())
+                    server->drop_interface(s.path, ptr->name());
+                added_servers.pop_front();
+            }
+            throw;
+        }
+    }
+
+    ptr->_owner = _self;
+    _interfaces.emplace(ptr->name(), ptr);
+    ptr->_listen_properties(ptr);
+}
+
 [[maybe_unused]] bool node::drop_interface(const std::string& name) {
     auto if_it = _interfaces.find(name);
     if (if_it == _interfaces.end())
         return false;
 
+    IPCGULL_PROBE2(node__drop__interface, _name.c_str(), name.c_str());
+
     for (auto& s: _servers) {
-        if (auto server = s.lock())
-            server->drop_interface(full_name(*server), name);
+        if (auto server = s.ptr.lock())
+            server->drop_interface(s.path, name);
     }
-    if (auto lock = if_it->second.lock())
+    if (auto lock = if_it->second.lock()) {
+        lock->_unlisten_properties();
         lock->_owner.reset();
+    }
     _interfaces.erase(if_it);
 
     return true;
@@ -113,7 +153,7 @@ std::shared_ptr<node> node::make_child(const std::string& name) const {
 void node::add_server(const std::weak_ptr<server>& s) {
     if (auto server = s.lock()) {
         for (auto& existing_server: _servers) {
-            if (existing_server.lock() == server)
+            if (existing_server.ptr.lock() == server)
                 return;
         }
 
@@ -132,26 +172,21 @@ void node::add_server(const std::weak_ptr<server>& s) {
                 throw;
             }
         }
-        _servers.push_front(s);
+        _servers.push_front({s, node_path});
     }
 }
 
 bool node::drop_server(const std::weak_ptr<server>& s) {
     auto server = s.lock();
-    bool server_found = false;
-    for (auto& existing_server: _servers) {
-        if (existing_server.lock() == server) {
-            server_found = true;
-            break;
-        }
-    }
-    if (!server_found)
+    auto it = _servers.begin();
+    while (it != _servers.end() && it->ptr.lock() != server)
+        ++it;
+    if (it == _servers.end())
         return false;
 
     if (server) {
-        const std::string node_path = full_name(*server);
         for (auto& x: _interfaces)
-            server->drop_interface(node_path, x.first);
+            server->drop_interface(it->path, x.first);
     }
 
     return true;
@@ -160,7 +195,7 @@ bool node::drop_server(const std::weak_ptr<server>& s) {
 void node::manage(const std::weak_ptr<object>& obj) {
     _managing = obj;
     for (auto& x: _servers) {
-        if (auto server = x.lock())
+        if (auto server = x.ptr.lock())
             server->set_managing(_self.lock(), obj);
     }
 }
@@ -171,21 +206,34 @@ const std::weak_ptr<object>& node::managed() const {
 
 void node::emit_signal(const std::string& iface,
                        const std::string& signal,
-                       const variant_tuple& args,
-                       const variant_type& args_type) const {
+                       const signal_payload& payload,
+                       const signal_policy& policy,
+                       const std::vector<std::string>& destinations) const {
+    IPCGULL_PROBE2(node__emit__signal, iface.c_str(), signal.c_str());
     for (auto& s: _servers) {
-        if (auto server = s.lock()) {
-            server->emit_signal(full_name(*server), iface,
-                                signal, args, args_type);
+        if (auto server = s.ptr.lock()) {
+            server->emit_signal(s.path, iface,
+                                signal, payload, policy, destinations);
         }
     }
 }
 
-const std::map<std::string, std::weak_ptr<interface>>&
-node::interfaces() const {
+void node::properties_changed(const std::string& iface,
+                              const std::string& property) const {
+    for (auto& s: _servers) {
+        if (auto server = s.ptr.lock())
+            server->property_changed(s.path, iface, property);
+    }
+}
+
+const node::interface_map& node::interfaces() const {
     return _interfaces;
 }
 
 const std::string& node::name() const {
     return _name;
 }
+
+const std::string& node::tree_name() const {
+    return _tree_name;
+}
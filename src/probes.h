@@ -0,0 +1,80 @@
+/*
+ * Copyright 2022 PixlOne
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef IPCGULL_PROBES_H
+#define IPCGULL_PROBES_H
+
+/*
+ * USDT probes under the "ipcgull" provider, enabled with -DIPCGULL_USDT=ON.
+ * A detached probe is a single nop. List them with:
+ *   bpftrace -l 'usdt:/path/to/binary:ipcgull:*'
+ *
+ * method__entry/method__return        (path, interface, member, sender)
+ * property__get__entry/__return       (path, interface, property, sender)
+ * property__set__entry/__return       (path, interface, property, sender)
+ * signal__emit                        (path, interface, member, size)
+ * interface__add/interface__drop      (path, interface)
+ * node__add__interface/__drop__interface (node name, interface)
+ * node__emit__signal                  (interface, member)
+ * name__acquired/name__lost           (name)
+ */
+
+#ifdef IPCGULL_USDT
+
+#include <utility>
+#include <sys/sdt.h>
+
+namespace ipcgull {
+    template<typename F>
+    class _probe_exit {
+        F _f;
+    public:
+        explicit _probe_exit(F f) : _f(std::move(f)) {}
+
+        ~_probe_exit() {
+            _f();
+        }
+
+        _probe_exit(const _probe_exit&) = delete;
+    };
+}
+
+#define IPCGULL_PROBE1(name, a1) \
+    DTRACE_PROBE1(ipcgull, name, a1)
+#define IPCGULL_PROBE2(name, a1, a2) \
+    DTRACE_PROBE2(ipcgull, name, a1, a2)
+#define IPCGULL_PROBE4(name, a1, a2, a3, a4) \
+    DTRACE_PROBE4(ipcgull, name, a1, a2, a3, a4)
+
+// Fires entry now and exit when the enclosing scope is left
+#define IPCGULL_PROBE4_SCOPE(entry, exit, a1, a2, a3, a4) \
+    IPCGULL_PROBE4(entry, a1, a2, a3, a4); \
+    const ::ipcgull::_probe_exit _ipcgull_probe_##exit([&]() { \
+        IPCGULL_PROBE4(exit, a1, a2, a3, a4); \
+    })
+
+#else
+
+#define IPCGULL_PROBE1(name, a1)
+#define IPCGULL_PROBE2(name, a1, a2)
+#define IPCGULL_PROBE4(name, a1, a2, a3, a4)
+#define IPCGULL_PROBE4_SCOPE(entry, exit, a1, a2, a3, a4)
+
+#endif
+
+#endif //IPCGULL_PROBES_H
@@ -16,24 +16,39 @@
  *
  */
 
+#include <algorithm>
 #include <ipcgull/interface.h>
 #include <ipcgull/property.h>
 
 using namespace ipcgull;
 
 variant base_property::get_variant() const {
+    return try_get_variant().value();
+}
+
+bool base_property::set_variant(const variant& value) {
+    const auto ret = try_set_variant(value);
+    if (ret)
+        return true;
+    if (ret.error().code() == error_invalid_args)
+        return false;
+    ret.error().raise();
+}
+
+result<variant> base_property::try_get_variant() const {
     if (permissions() & property_readable)
         return _get();
-    throw permission_denied("property not readable");
+    return call_error(error_access_denied, "property not readable");
 }
 
-///TODO: org.freedesktop.DBus.Properties support
-bool base_property::set_variant(const variant& value) {
+result<void> base_property::try_set_variant(const variant& value) {
     if (!(permissions() & property_writeable))
-        throw permission_denied("property not writeable");
-    if (_validate(value))
-        return _set(value);
-    return false;
+        return call_error(error_property_read_only,
+                          "property not writeable");
+    auto ret = _set(value);
+    if (ret)
+        notify_change();
+    return ret;
 }
 
 const variant_type& base_property::type() const {
@@ -45,6 +60,144 @@ property_permissions base_property::permissions() const {
 }
 
 
+uint64_t base_property::version() const {
+    return _state->version.load(std::memory_order_acquire);
+}
+
+std::shared_ptr<const void> base_property::cached(uint64_t version) const {
+    if (!_cacheable)
+        return nullptr;
+    std::lock_guard<std::mutex> lock(_state->cache_lock);
+    if (_state->cache_version != version)
+        return nullptr;
+    return _state->cache;
+}
+
+void base_property::cache(uint64_t version,
+                          std::shared_ptr<const void> encoded) const {
+    if (!_cacheable)
+        return;
+    // Swapped out so the old encoding is released outside the lock
+    std::lock_guard<std::mutex> lock(_state->cache_lock);
+    if (_state->cache && _state->cache_version > version)
+        return;
+    _state->cache_version = version;
+    _state->cache.swap(encoded);
+}
+
 void base_property::notify_change() const {
-    /// TODO: Support PropertiesChanged signal
-}
\ No newline at end of file
+    // The value is already stored, so an encoding made before this is
+    // tagged with an old version and never served again
+    _state->version.fetch_add(1, std::memory_order_acq_rel);
+
+    std::vector<_property_state::listener> listeners;
+    std::vector<std::function<void()>> observers;
+    {
+        std::lock_guard<std::mutex> lock(_state->lock);
+        listeners = _state->listeners;
+        observers.reserve(_state->observers.size());
+        for (auto& x: _state->observers)
+            observers.push_back(x.second);
+    }
+
+    for (auto& x: listeners) {
+        if (auto iface = x.iface.lock())
+            iface->_property_changed(x.name);
+    }
+
+    for (auto& x: observers)
+        x();
+}
+
+void base_property::_emit_deltas(signal delta_signal) {
+    _delta_signal.emplace(std::move(delta_signal));
+}
+
+void base_property::notify_delta(const std::vector<variant>& args) const {
+    if (!_delta_signal)
+        return;
+
+    std::vector<_property_state::listener> listeners;
+    {
+        std::lock_guard<std::mutex> lock(_state->lock);
+        listeners = _state->listeners;
+    }
+
+    for (auto& x: listeners) {
+        if (auto iface = x.iface.lock())
+            iface->_property_delta(x.name, args, *_delta_signal);
+    }
+}
+
+const std::optional<signal>& base_property::delta_signal() const {
+    return _delta_signal;
+}
+
+subscription base_property::_subscribe(std::function<void()> f) const {
+    std::lock_guard<std::mutex> lock(_state->lock);
+    const auto id = ++_state->next_observer;
+    _state->observers.emplace_back(id, std::move(f));
+    return {_state, id};
+}
+
+subscription::subscription(std::weak_ptr<_property_state> state,
+                           uint64_t id) :
+        _state(std::move(state)), _id(id) {
+}
+
+subscription::subscription(subscription&& o) noexcept :
+        _state(std::move(o._state)), _id(o._id) {
+    o._id = 0;
+}
+
+subscription& subscription::operator=(subscription&& o) noexcept {
+    if (this != &o) {
+        unsubscribe();
+        _state = std::move(o._state);
+        _id = o._id;
+        o._id = 0;
+    }
+    return *this;
+}
+
+subscription::~subscription() {
+    unsubscribe();
+}
+
+void subscription::unsubscribe() {
+    auto state = _state.lock();
+    _state.reset();
+    if (!state || !_id)
+        return;
+
+    // Destroyed outside the lock, the observer may own a property copy
+    std::function<void()> removed;
+    {
+        std::lock_guard<std::mutex> lock(state->lock);
+        auto& observers = state->observers;
+        auto it = std::find_if(observers.begin(), observers.end(),
+                               [this](auto& x) { return x.first == _id; });
+        if (it != observers.end()) {
+            removed = std::move(it->second);
+            observers.erase(it);
+        }
+    }
+    _id = 0;
+}
+
+void base_property::_listen(const std::weak_ptr<const interface>& iface,
+                            const std::string& name) const {
+    std::lock_guard<std::mutex> lock(_state->lock);
+    _state->listeners.push_back({iface, name});
+}
+
+void base_property::_unlisten(const interface* iface) const {
+    std::lock_guard<std::mutex> lock(_state->lock);
+    auto& listeners = _state->listeners;
+    listeners.erase(std::remove_if(
+            listeners.begin(), listeners.end(),
+            [iface](const _property_state::listener& x) {
+                auto ptr = x.iface.lock();
+                return !ptr || ptr.get() == iface;
+            }), listeners.end());
+}
@@ -0,0 +1,61 @@
+/*
+ * Copyright 2022 PixlOne
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <ipcgull/exception.h>
+#include <ipcgull/result.h>
+
+using namespace ipcgull;
+
+call_error::call_error(error_code code, std::string message) :
+        _code(code), _message(std::move(message)) {
+}
+
+call_error::call_error(std::string name, std::string message) :
+        _code(error_failed), _name(std::move(name)),
+        _message(std::move(message)) {
+}
+
+error_code call_error::code() const {
+    return _code;
+}
+
+const std::string& call_error::name() const {
+    return _name;
+}
+
+const std::string& call_error::message() const {
+    return _message;
+}
+
+void call_error::raise() const {
+    switch (_code) {
+        case error_invalid_signature:
+            throw std::bad_variant_access();
+        case error_invalid_args:
+            throw std::invalid_argument(_message);
+        case error_unknown_property:
+            throw std::out_of_range(_message);
+        case error_property_read_only:
+        case error_access_denied:
+            throw permission_denied(_message);
+        case error_timeout:
+            throw call_cancelled(_message);
+        default:
+            throw std::runtime_error(_message);
+    }
+}
@@ -16,19 +16,29 @@
  *
  */
 
+#include <algorithm>
 #include <atomic>
 #include <condition_variable>
+#include <limits>
 #include <mutex>
+#include <optional>
+#include <set>
 #include <stdexcept>
 #include <cassert>
+#include <string_view>
+#include <tuple>
 #include <utility>
 #include <gio/gio.h>
+#include <ipcgull/call_context.h>
 #include <ipcgull/exception.h>
 #include <ipcgull/node.h>
 #include <ipcgull/interface.h>
 #include <ipcgull/server.h>
 
 #include "common_gdbus.h"
+#include "mpmc_ring.h"
+#include "probes.h"
+#include "signal_throttle.h"
 
 using namespace ipcgull;
 
@@ -48,18 +58,57 @@ namespace ipcgull {
         template<typename... Args>
         explicit _server(Args... args) : server(std::forward<Args>(args)...) {}
     };
+
+    // The marshalled arguments are only kept if they do not refer to
+    // objects, whose paths are looked up per server
+    struct signal_payload::internal {
+        variant_tuple args;
+        variant_type args_type;
+        bool server_independent;
+        std::once_flag marshalled;
+        GVariant* value = nullptr;
+
+        ~internal() {
+            if (value)
+                g_variant_unref(value);
+        }
+    };
+
+    static bool references_objects(const variant& v) {
+        if (std::holds_alternative<std::shared_ptr<object>>(v))
+            return true;
+
+        if (const auto* vector = std::get_if<std::vector<variant>>(&v)) {
+            return std::any_of(vector->begin(), vector->end(),
+                               references_objects);
+        } else if (const auto* tuple = std::get_if<variant_tuple>(&v)) {
+            const std::vector<variant>& items = *tuple;
+            return std::any_of(items.begin(), items.end(),
+                               references_objects);
+        } else if (const auto* map =
+                std::get_if<std::map<variant, variant>>(&v)) {
+            return std::any_of(map->begin(), map->end(),
+                               [](const auto& x) {
+                                   return references_objects(x.first) ||
+                                          references_objects(x.second);
+                               });
+        }
+
+        return false;
+    }
 }
 
 struct server::internal {
     struct internal_node {
         std::weak_ptr<node> object;
-        std::map<std::string, guint> interfaces;
+        std::map<std::string, guint, std::less<>> interfaces;
 
         explicit internal_node(std::weak_ptr<node> obj) :
                 object(std::move(obj)) {}
     };
 
-    std::map<std::string, internal_node> nodes;
+    // Transparent so the GDBus callbacks can look up by C string
+    std::map<std::string, internal_node, std::less<>> nodes;
     std::map<object*, std::string> object_path_lookup;
 
     GDBusConnection* connection = nullptr;
@@ -75,6 +124,291 @@ struct server::internal {
 
     std::atomic_bool stop_requested = false;
 
+    struct sender_watch {
+        // Serial of the GetNameOwner call confirming the sender had not
+        // left before it was watched, 0 once answered
+        guint32 owner_check = 0;
+        // Calls from the sender still being handled
+        std::size_t calls = 0;
+        std::chrono::steady_clock::time_point last_call;
+        std::shared_ptr<std::atomic_bool> disconnected;
+    };
+
+    // Watches of senders that stopped calling are kept this long, so a
+    // busy caller costs a single GetNameOwner
+    static constexpr std::chrono::seconds sender_idle_expiry{60};
+
+    struct latency_lookup {
+        call_kind kind;
+        std::string_view interface;
+        std::string_view member;
+    };
+
+    struct latency_compare {
+        typedef void is_transparent;
+
+        template<typename A, typename B>
+        bool operator()(const A& a, const B& b) const {
+            return std::tie(a.kind, a.interface, a.member) <
+                   std::tie(b.kind, b.interface, b.member);
+        }
+    };
+
+    // Entries are only created for existing members, guarded by server_lock
+    std::map<latency_key, call_latency, latency_compare> latency;
+
+    call_latency& latency_for(call_kind kind, const gchar* iface,
+                              const gchar* member) {
+        auto it = latency.find(latency_lookup{kind, iface, member});
+        if (it == latency.end()) {
+            it = latency.emplace(
+                    std::piecewise_construct,
+                    std::forward_as_tuple(latency_key{kind, iface, member}),
+                    std::forward_as_tuple()).first;
+        }
+
+        return it->second;
+    }
+
+    struct counters {
+        std::atomic<uint64_t> method_calls{0};
+        std::atomic<uint64_t> property_gets{0};
+        std::atomic<uint64_t> property_sets{0};
+        std::atomic<uint64_t> errors{0};
+        std::atomic<uint64_t> bytes_in{0};
+        std::atomic<uint64_t> bytes_out{0};
+        std::atomic<uint64_t> signals{0};
+        std::atomic<uint64_t> signals_dropped{0};
+        std::atomic<uint64_t> signals_coalesced{0};
+        std::atomic<uint64_t> pending{0};
+        std::atomic<uint64_t> lock_wait_ns{0};
+        std::atomic<uint64_t> lock_wait_max_ns{0};
+    } counters;
+
+    // Signals emitted per whole second, guarded by server_lock
+    int64_t signal_window = 0;
+    uint64_t signal_window_count = 0;
+    uint64_t signal_last_window_count = 0;
+
+    guint stats_registration = 0;
+
+    // Guarded by server_lock, which is held for the whole dispatch
+    std::shared_ptr<observer> tracer_owner;
+    observer* tracer = nullptr;
+
+    // Costs a single branch unless an observer is installed
+    class trace_span {
+        observer* const _observer;
+        span_info _info{};
+    public:
+        trace_span(observer* o, span_kind kind,
+                   const gchar* object_path, const gchar* iface,
+                   const gchar* member, const gchar* sender,
+                   std::size_t payload_size) : _observer(o) {
+            if (_observer) {
+                _info = {kind, object_path ? object_path : "",
+                         iface ? iface : "", member ? member : "",
+                         sender ? sender : "", payload_size};
+                _observer->begin(_info);
+            }
+        }
+
+        ~trace_span() {
+            if (_observer)
+                _observer->end(_info);
+        }
+
+        trace_span(const trace_span&) = delete;
+
+        void payload_size(std::size_t size) {
+            _info.payload_size = size;
+        }
+    };
+
+    // Counts the calls currently being dispatched
+    class pending_call {
+        std::atomic<uint64_t>& _pending;
+    public:
+        explicit pending_call(internal& i) : _pending(i.counters.pending) {
+            ++_pending;
+        }
+
+        ~pending_call() {
+            --_pending;
+        }
+    };
+
+    std::unique_lock<std::recursive_mutex> lock_server() {
+        const auto start = std::chrono::steady_clock::now();
+        std::unique_lock<std::recursive_mutex> lock(server_lock);
+        const auto waited = static_cast<uint64_t>(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        std::chrono::steady_clock::now() - start).count());
+
+        counters.lock_wait_ns += waited;
+        auto prev_max = counters.lock_wait_max_ns.load();
+        while (prev_max < waited &&
+               !counters.lock_wait_max_ns.compare_exchange_weak(prev_max,
+                                                               waited)) {}
+
+        return lock;
+    }
+
+    void roll_signal_window() {
+        const auto now = std::chrono::duration_cast<std::chrono::seconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+        if (now != signal_window) {
+            signal_last_window_count =
+                    (now == signal_window + 1) ? signal_window_count : 0;
+            signal_window_count = 0;
+            signal_window = now;
+        }
+    }
+
+    server_stats stats() {
+        server_stats ret;
+        // Dispatch holds server_lock for the whole call, so this must be
+        // read before waiting for it
+        ret.pending_calls = counters.pending;
+
+        std::lock_guard<std::recursive_mutex> lock(server_lock);
+        ret.method_calls = counters.method_calls;
+        ret.property_gets = counters.property_gets;
+        ret.property_sets = counters.property_sets;
+        ret.errors = counters.errors;
+        ret.bytes_in = counters.bytes_in;
+        ret.bytes_out = counters.bytes_out;
+        ret.signals_emitted = counters.signals;
+        ret.signals_dropped = counters.signals_dropped;
+        ret.signals_coalesced = counters.signals_coalesced;
+        roll_signal_window();
+        ret.signal_rate = signal_last_window_count;
+        ret.lock_wait_total = std::chrono::nanoseconds(counters.lock_wait_ns);
+        ret.lock_wait_max = std::chrono::nanoseconds(
+                counters.lock_wait_max_ns);
+        ret.objects = nodes.size();
+        for (auto& x: nodes)
+            ret.interfaces += x.second.interfaces.size();
+
+        return ret;
+    }
+
+    void return_error(GDBusMethodInvocation* invocation,
+                      gint code, const gchar* message) {
+        ++counters.errors;
+        g_dbus_method_invocation_return_error(invocation, G_DBUS_ERROR,
+                                              code, "%s", message);
+    }
+
+    void set_error(GError** error, gint code, const gchar* message) {
+        ++counters.errors;
+        g_set_error(error, G_DBUS_ERROR, code, "%s", message);
+    }
+
+    static gint dbus_error_code(error_code code) {
+        switch (code) {
+            case error_invalid_args:
+                return G_DBUS_ERROR_INVALID_ARGS;
+            case error_invalid_signature:
+                return G_DBUS_ERROR_INVALID_SIGNATURE;
+            case error_unknown_property:
+                return G_DBUS_ERROR_UNKNOWN_PROPERTY;
+            case error_property_read_only:
+                return G_DBUS_ERROR_PROPERTY_READ_ONLY;
+            case error_access_denied:
+                return G_DBUS_ERROR_ACCESS_DENIED;
+            case error_timeout:
+                return G_DBUS_ERROR_TIMEOUT;
+            case error_not_supported:
+                return G_DBUS_ERROR_NOT_SUPPORTED;
+            default:
+                return G_DBUS_ERROR_FAILED;
+        }
+    }
+
+    void return_error(GDBusMethodInvocation* invocation,
+                      const call_error& e) {
+        if (e.name().empty()) {
+            return_error(invocation, dbus_error_code(e.code()),
+                         e.message().c_str());
+        } else {
+            ++counters.errors;
+            g_dbus_method_invocation_return_dbus_error(
+                    invocation, e.name().c_str(), e.message().c_str());
+        }
+    }
+
+    void set_error(GError** error, const call_error& e) {
+        if (e.name().empty()) {
+            set_error(error, dbus_error_code(e.code()), e.message().c_str());
+        } else {
+            ++counters.errors;
+            g_dbus_error_set_dbus_error(error, e.name().c_str(),
+                                        e.message().c_str(), nullptr);
+        }
+    }
+
+    // Also accessed from the GDBus worker thread by the sender filter
+    std::mutex sender_lock;
+    std::map<std::string, sender_watch> senders;
+    std::map<guint32, std::string> owner_checks;
+    std::size_t sender_sweep_at = 64;
+    guint sender_filter = 0;
+    // NameOwnerChanged for every name, added by the first cancellable call
+    guint sender_subscription = 0;
+
+    // Properties changed since the last flush, keyed by object path and
+    // interface. Queued from any thread, so not guarded by server_lock.
+    std::mutex changes_lock;
+    std::map<std::pair<std::string, std::string>,
+            std::set<std::string>> changes;
+    guint changes_source = 0;
+    std::chrono::milliseconds changes_window{0};
+
+    // Signals waiting for the main loop, see server::set_signal_queue()
+    struct queued_signal {
+        std::string node;
+        std::string iface;
+        std::string signal;
+        signal_payload payload;
+        std::vector<std::string> destinations;
+    };
+
+    typedef mpmc_ring<std::unique_ptr<queued_signal>> signal_ring;
+
+    // Replaced under server_lock, loaded atomically by emitters
+    std::shared_ptr<signal_ring> signal_queue;
+    std::atomic_bool signal_drain_scheduled = false;
+    // Bumped by every drain, so emitters blocked on a full queue can wait
+    // for room
+    std::mutex drain_lock;
+    std::condition_variable drained;
+    uint64_t drain_count = 0;
+
+    // Per-signal state for signal_policy::min_interval and
+    // coalesce_latest, keyed by path, interface, member and destinations
+    // (joined by ','). Emitted from any thread, so not guarded by
+    // server_lock.
+    typedef std::tuple<std::string, std::string, std::string, std::string>
+            signal_key;
+
+    struct throttled_signal {
+        signal_throttle<signal_payload> throttle;
+        signal_policy policy;
+        std::vector<std::string> destinations;
+        guint source = 0;
+    };
+
+    struct throttle_flush {
+        std::weak_ptr<internal> i;
+        signal_key key;
+    };
+
+    std::mutex throttle_lock;
+    std::map<signal_key, throttled_signal> throttled;
+    // Idle entries are swept when the map reaches this size
+    std::size_t throttle_sweep_at = 64;
+
     variant from_gvariant(GVariant* v) {
         if (v == nullptr)
             return variant_tuple();
@@ -297,112 +631,735 @@ struct server::internal {
         }
     }
 
+    // New reference to the encoding cached since the property's last
+    // write, or null
+    static GVariant* cached_gvariant(const base_property& p,
+                                     uint64_t version) {
+        const auto cached = p.cached(version);
+        if (!cached)
+            return nullptr;
+        return g_variant_ref(static_cast<GVariant*>(
+                const_cast<void*>(cached.get())));
+    }
+
+    // Sinks g_value, the encoding of value, caches it for `version` and
+    // returns it. Object paths can change without a write to the property
+    // (see node::manage), so values referencing objects are not cached.
+    static GVariant* cache_gvariant(const base_property& p,
+                                    uint64_t version, const variant& value,
+                                    GVariant* g_value) {
+        g_value = g_variant_ref_sink(g_value);
+        if (references_objects(value))
+            return g_value;
+        p.cache(version, std::shared_ptr<const void>(
+                g_variant_ref(g_value), [](const void* x) {
+                    g_variant_unref(static_cast<GVariant*>(
+                            const_cast<void*>(x)));
+                }));
+        return g_value;
+    }
+
+    // The subscription only adds the match rule, NameOwnerChanged is
+    // handled by sender_filter_handler on the worker thread
+    static void sender_vanished_handler(
+            [[maybe_unused]] GDBusConnection* connection,
+            [[maybe_unused]] const gchar* sender,
+            [[maybe_unused]] const gchar* object_path,
+            [[maybe_unused]] const gchar* interface_name,
+            [[maybe_unused]] const gchar* signal_name,
+            [[maybe_unused]] GVariant* parameters,
+            [[maybe_unused]] gpointer user_data) {
+    }
+
+    // sender_lock must be held
+    void drop_sender(std::map<std::string, sender_watch>::iterator it) {
+        if (it->second.owner_check)
+            owner_checks.erase(it->second.owner_check);
+        senders.erase(it);
+    }
+
+    // sender_lock must be held. Unique names are never reused, so the
+    // watch of a sender that left goes with its last call.
+    void sender_left(std::map<std::string, sender_watch>::iterator it) {
+        *it->second.disconnected = true;
+        if (!it->second.calls)
+            drop_sender(it);
+    }
+
+    // Forgets senders that have not called for sender_idle_expiry.
+    // Amortized O(1) per call; sender_lock must be held.
+    void sweep_senders(std::chrono::steady_clock::time_point now) {
+        if (senders.size() < sender_sweep_at)
+            return;
+        for (auto it = senders.begin(); it != senders.end();) {
+            auto next = std::next(it);
+            if (!it->second.calls &&
+                now - it->second.last_call >= sender_idle_expiry)
+                drop_sender(it);
+            it = next;
+        }
+        sender_sweep_at = std::max<std::size_t>(64, senders.size() * 2);
+    }
+
+    // Called from the GDBus worker thread with the bus' reply to a
+    // GetNameOwner sent by sender_call
+    void owner_checked(GDBusMessage* reply) {
+        std::lock_guard<std::mutex> lock(sender_lock);
+        auto check = owner_checks.find(
+                g_dbus_message_get_reply_serial(reply));
+        if (check == owner_checks.end())
+            return;
+
+        auto it = senders.find(check->second);
+        owner_checks.erase(check);
+        if (it == senders.end())
+            return;
+
+        it->second.owner_check = 0;
+        // NameHasNoOwner: the sender left before it was watched, so no
+        // NameOwnerChanged is coming
+        if (g_dbus_message_get_message_type(reply) ==
+            G_DBUS_MESSAGE_TYPE_ERROR)
+            sender_left(it);
+    }
+
+    // Runs on the GDBus worker thread, so handlers blocking the main loop
+    // still see their caller disconnect. The match rule that lets these
+    // messages through is added by sender_call.
+    static GDBusMessage* sender_filter_handler(
+            [[maybe_unused]] GDBusConnection* connection,
+            GDBusMessage* message,
+            gboolean incoming,
+            gpointer internal_weak) {
+        if (!incoming || g_strcmp0(g_dbus_message_get_sender(message),
+                                   "org.freedesktop.DBus") != 0)
+            return message;
+
+        const auto type = g_dbus_message_get_message_type(message);
+        if (type == G_DBUS_MESSAGE_TYPE_METHOD_RETURN ||
+            type == G_DBUS_MESSAGE_TYPE_ERROR) {
+            if (auto i = static_cast<std::weak_ptr<internal>*>(
+                    internal_weak)->lock())
+                i->owner_checked(message);
+            return message;
+        }
+
+        if (type != G_DBUS_MESSAGE_TYPE_SIGNAL ||
+            g_strcmp0(g_dbus_message_get_member(message),
+                      "NameOwnerChanged") != 0)
+            return message;
+
+        auto* body = g_dbus_message_get_body(message);
+        if (!body || !g_variant_is_of_type(body, G_VARIANT_TYPE("(sss)")))
+            return message;
+
+        const gchar* name, * old_owner, * new_owner;
+        g_variant_get(body, "(&s&s&s)", &name, &old_owner, &new_owner);
+        if (*new_owner)
+            return message;
+
+        if (auto i = static_cast<std::weak_ptr<internal>*>(
+                internal_weak)->lock()) {
+            std::lock_guard<std::mutex> lock(i->sender_lock);
+            auto it = i->senders.find(name);
+            if (it != i->senders.end())
+                i->sender_left(it);
+        }
+
+        return message;
+    }
+
+    // Watches the sender of a cancellable call, see
+    // function::set_cancel_on_disconnect(). Peer-to-peer connections and
+    // other calls have no sender to watch.
+    class sender_call {
+        const std::shared_ptr<internal> _internal;
+        const std::string _sender;
+        std::shared_ptr<const std::atomic_bool> _disconnected;
+    public:
+        sender_call(const std::shared_ptr<internal>& i, const gchar* sender) :
+                _internal(i), _sender(sender ? sender : "") {
+            if (!sender)
+                return;
+
+            std::lock_guard<std::mutex> lock(i->sender_lock);
+            if (!i->sender_subscription) {
+                i->sender_subscription = g_dbus_connection_signal_subscribe(
+                        i->connection, "org.freedesktop.DBus",
+                        "org.freedesktop.DBus", "NameOwnerChanged",
+                        "/org/freedesktop/DBus", nullptr,
+                        G_DBUS_SIGNAL_FLAGS_NONE,
+                        sender_vanished_handler, nullptr, nullptr);
+            }
+
+            auto it = i->senders.find(_sender);
+            if (it == i->senders.end()) {
+                it = i->senders.emplace(_sender, sender_watch()).first;
+                it->second.disconnected =
+                        std::make_shared<std::atomic_bool>(false);
+                check_owner(it);
+            }
+
+            ++it->second.calls;
+            _disconnected = it->second.disconnected;
+        }
+
+        ~sender_call() {
+            if (!_disconnected)
+                return;
+
+            const auto now = std::chrono::steady_clock::now();
+            std::lock_guard<std::mutex> lock(_internal->sender_lock);
+            auto it = _internal->senders.find(_sender);
+            // The watch may belong to an earlier connection
+            if (it != _internal->senders.end() &&
+                it->second.disconnected == _disconnected) {
+                it->second.last_call = now;
+                if (!--it->second.calls && *_disconnected)
+                    _internal->drop_sender(it);
+            }
+            _internal->sweep_senders(now);
+        }
+
+        sender_call(const sender_call&) = delete;
+
+        [[nodiscard]] cancellation_token token(
+                std::chrono::milliseconds timeout) const {
+            auto deadline = cancellation_token::clock::time_point::max();
+            if (timeout.count() > 0)
+                deadline = cancellation_token::clock::now() + timeout;
+            return {_disconnected, deadline};
+        }
+
+    private:
+        // The sender may have left before its watch existed (its
+        // NameOwnerChanged already went by), ask the bus once. The reply is
+        // picked up by the sender filter
+        // on the worker thread, so it still lands while a handler blocks
+        // the main loop.
+        void check_owner(std::map<std::string, sender_watch>::iterator it) {
+            auto* message = g_dbus_message_new_method_call(
+                    "org.freedesktop.DBus", "/org/freedesktop/DBus",
+                    "org.freedesktop.DBus", "GetNameOwner");
+            g_dbus_message_set_body(message, g_variant_new(
+                    "(s)", _sender.c_str()));
+            guint32 serial = 0;
+            // sender_lock is held, so the filter cannot see the reply
+            // before the serial is recorded
+            if (g_dbus_connection_send_message(
+                    _internal->connection, message,
+                    G_DBUS_SEND_MESSAGE_FLAGS_NONE, &serial, nullptr) &&
+                serial) {
+                it->second.owner_check = serial;
+                _internal->owner_checks.emplace(serial, _sender);
+            }
+            g_object_unref(message);
+        }
+    };
+
+    static void watch_senders(const std::shared_ptr<internal>& i) {
+        assert(i->connection);
+        i->sender_filter = g_dbus_connection_add_filter(
+                i->connection, sender_filter_handler,
+                new std::weak_ptr<internal>(i), free_internal_weak);
+    }
+
+    // Callers on a lost connection can never receive a reply
+    void forget_senders() {
+        std::lock_guard<std::mutex> lock(sender_lock);
+        for (auto& x: senders)
+            *x.second.disconnected = true;
+        senders.clear();
+        owner_checks.clear();
+
+        if (sender_subscription) {
+            g_dbus_connection_signal_unsubscribe(connection,
+                                                 sender_subscription);
+            sender_subscription = 0;
+        }
+
+        if (sender_filter) {
+            g_dbus_connection_remove_filter(connection, sender_filter);
+            sender_filter = 0;
+        }
+    }
+
+    static constexpr const gchar* properties_interface =
+            "org.freedesktop.DBus.Properties";
+
+    // Handles org.freedesktop.DBus.Properties.Get and GetAll. lock holds
+    // server_lock once, see read_uncached().
+    void properties_call(std::unique_lock<std::recursive_mutex>& lock,
+                         const gchar* sender,
+                         const gchar* object_path,
+                         const gchar* method_name,
+                         GVariant* parameters,
+                         GDBusMethodInvocation* invocation) {
+        ++counters.property_gets;
+        const bool get_all = g_strcmp0(method_name, "GetAll") == 0;
+        const gchar* interface_name = nullptr;
+        const gchar* property_name = nullptr;
+        if (get_all)
+            g_variant_get(parameters, "(&s)", &interface_name);
+        else
+            g_variant_get(parameters, "(&s&s)", &interface_name,
+                          &property_name);
+
+        auto weak_node = nodes.find(object_path);
+        if (weak_node == nodes.end()) {
+            return_error(invocation, G_DBUS_ERROR_UNKNOWN_OBJECT,
+                         "Unknown object");
+            return;
+        }
+        auto node = weak_node->second.object.lock();
+        if (!node) {
+            // This shouldn't happen, but handle the case it does.
+            return_error(invocation, G_DBUS_ERROR_UNKNOWN_OBJECT,
+                         "Object no longer exists");
+            return;
+        }
+        auto iface_it = node->interfaces().find(interface_name);
+        if (iface_it == node->interfaces().end()) {
+            return_error(invocation, G_DBUS_ERROR_UNKNOWN_INTERFACE,
+                         "Unknown interface");
+            return;
+        }
+        auto iface = iface_it->second.lock();
+        if (!iface) {
+            return_error(invocation, G_DBUS_ERROR_UNKNOWN_INTERFACE,
+                         "Interface expired");
+            return;
+        }
+
+        if (get_all)
+            get_all_properties(lock, *iface, sender, object_path,
+                               interface_name, invocation);
+        else
+            get_property(lock, *iface, sender, object_path,
+                         interface_name, property_name, invocation);
+    }
+
+    // Reads through read_uncached() so that, like GetAll, a single Get
+    // never observes a property written by a transaction still open
+    void get_property(std::unique_lock<std::recursive_mutex>& lock,
+                      const interface& iface,
+                      const gchar* sender,
+                      const gchar* object_path,
+                      const gchar* interface_name,
+                      const gchar* property_name,
+                      GDBusMethodInvocation* invocation) {
+        IPCGULL_PROBE4_SCOPE(property__get__entry, property__get__return,
+                             object_path, interface_name, property_name,
+                             sender);
+        const auto* property = iface.find_property(property_name);
+        if (!property) {
+            return_error(invocation, G_DBUS_ERROR_UNKNOWN_PROPERTY,
+                         "Unknown property");
+            return;
+        }
+        if (!(property->permissions() & property_readable)) {
+            return_error(invocation, call_error(error_access_denied,
+                                                "property not readable"));
+            return;
+        }
+
+        auto& latency = latency_for(
+                call_get_property, interface_name, property_name);
+        auto phase_start = std::chrono::steady_clock::now();
+        std::vector<cached_property> cached;
+        try {
+            const std::string name = property_name;
+            const auto values = [&]() {
+                trace_span span(tracer, span_handler, object_path,
+                                interface_name, property_name,
+                                sender, 0);
+                return read_uncached(
+                        lock, iface,
+                        [&name](const std::string& x) { return x == name; },
+                        cached);
+            }();
+            GVariant* g_value;
+            if (!cached.empty()) {
+                g_value = cached.front().value;
+                cached.clear();
+            } else if (!values.empty()) {
+                latency.record(phase_handler, phase_start);
+                auto& x = values.front();
+                g_value = [&]() {
+                    trace_span span(tracer, span_encode, object_path,
+                                    interface_name, property_name,
+                                    sender, 0);
+                    auto* ret = to_gvariant(x.value, property->type());
+                    span.payload_size(g_variant_get_size(ret));
+                    return ret;
+                }();
+                g_value = cache_gvariant(*property, x.version, x.value,
+                                         g_value);
+                latency.record(phase_encode, phase_start);
+            } else {
+                return_error(invocation, G_DBUS_ERROR_UNKNOWN_PROPERTY,
+                             "Unknown property");
+                return;
+            }
+            counters.bytes_out += g_variant_get_size(g_value);
+
+            g_dbus_method_invocation_return_value(
+                    invocation, g_variant_new("(v)", g_value));
+            g_variant_unref(g_value);
+            latency.record(phase_reply, phase_start);
+        } catch (std::exception& e) {
+            for (auto& x: cached)
+                g_variant_unref(x.value);
+            return_error(invocation, G_DBUS_ERROR_FAILED, e.what());
+        }
+    }
+
+    struct cached_property {
+        const std::string* name;
+        GVariant* value;
+    };
+
+    // One consistent read of the readable properties accepted by filter.
+    // Cached encodings are added to `cached` as new references and only
+    // the other properties are read.
+    //
+    // The read waits for open transactions, whose owners may need
+    // server_lock to emit signals, so server_lock is released around it.
+    // lock must hold it exactly once.
+    static std::vector<interface::property_value> read_uncached(
+            std::unique_lock<std::recursive_mutex>& lock,
+            const interface& iface,
+            const std::function<bool(const std::string&)>& filter,
+            std::vector<cached_property>& cached) {
+        lock.unlock();
+        struct relock {
+            std::unique_lock<std::recursive_mutex>& lock;
+
+            ~relock() {
+                lock.lock();
+            }
+        } relock{lock};
+
+        return iface.read_properties(
+                [&filter, &cached](const std::string& name,
+                                   const base_property& p) {
+                    if (filter && !filter(name))
+                        return false;
+                    auto* g_value = cached_gvariant(p, p.version());
+                    if (!g_value)
+                        return true;
+                    cached.push_back({&name, g_value});
+                    return false;
+                });
+    }
+
+    // Adds the results of read_uncached() to an a{sv} builder, releasing
+    // the cached references and caching the new encodings
+    void add_properties(
+            GVariantBuilder& builder,
+            std::vector<cached_property>& cached,
+            const std::vector<interface::property_value>& values) {
+        for (auto& x: cached) {
+            g_variant_builder_add(&builder, "{sv}", x.name->c_str(),
+                                  x.value);
+            g_variant_unref(x.value);
+        }
+        cached.clear();
+        for (auto& x: values) {
+            auto* g_value = cache_gvariant(
+                    *x.property, x.version, x.value,
+                    to_gvariant(x.value, x.property->type()));
+            g_variant_builder_add(&builder, "{sv}", x.name->c_str(),
+                                  g_value);
+            g_variant_unref(g_value);
+        }
+    }
+
+    // One pass over the interface, see interface::read_properties()
+    void get_all_properties(std::unique_lock<std::recursive_mutex>& lock,
+                            const interface& iface,
+                            const gchar* sender,
+                            const gchar* object_path,
+                            const gchar* interface_name,
+                            GDBusMethodInvocation* invocation) {
+        auto& latency = latency_for(call_get_property, interface_name, "");
+        auto phase_start = std::chrono::steady_clock::now();
+        std::vector<cached_property> cached;
+        GVariantBuilder builder;
+        g_variant_builder_init(&builder, G_VARIANT_TYPE_VARDICT);
+        try {
+            const auto values = [&]() {
+                trace_span span(tracer, span_handler, object_path,
+                                interface_name, "GetAll", sender, 0);
+                return read_uncached(lock, iface, nullptr, cached);
+            }();
+            latency.record(phase_handler, phase_start);
+
+            auto* reply = [&]() {
+                trace_span span(tracer, span_encode, object_path,
+                                interface_name, "GetAll", sender, 0);
+                add_properties(builder, cached, values);
+                auto* ret = g_variant_new("(a{sv})", &builder);
+                span.payload_size(g_variant_get_size(ret));
+                return ret;
+            }();
+            latency.record(phase_encode, phase_start);
+            counters.bytes_out += g_variant_get_size(reply);
+
+            g_dbus_method_invocation_return_value(invocation, reply);
+            latency.record(phase_reply, phase_start);
+        } catch (std::exception& e) {
+            for (auto& x: cached)
+                g_variant_unref(x.value);
+            g_variant_builder_clear(&builder);
+            return_error(invocation, G_DBUS_ERROR_FAILED, e.what());
+        }
+    }
+
+    // Readable properties written after `since`, read like GetAll. A
+    // client resyncs by passing the generation and version from its
+    // previous call. A since of 0, another generation (e.g. from before a
+    // restart) or a version newer than the interface's gets every
+    // readable property.
+    void get_changed_since(std::unique_lock<std::recursive_mutex>& lock,
+                           const interface& iface,
+                           const gchar* sender,
+                           const gchar* object_path,
+                           const gchar* interface_name,
+                           GVariant* parameters,
+                           GDBusMethodInvocation* invocation) {
+        auto& latency = latency_for(call_method, interface_name,
+                                    changed_since_method);
+        auto phase_start = std::chrono::steady_clock::now();
+        guint64 generation = 0;
+        guint64 since = 0;
+        g_variant_get(parameters, "(tt)", &generation, &since);
+
+        // Taken first, so a write racing the read is sent again next time
+        // rather than missed
+        const auto version = iface.properties_version();
+        const bool resync = generation != iface.generation() ||
+                            since == 0 || since > version;
+        std::function<bool(const std::string&)> filter;
+        if (!resync) {
+            filter = [&iface, since](const std::string& name) {
+                return iface.property_changed_at(name) > since;
+            };
+        }
+
+        std::vector<cached_property> cached;
+        GVariantBuilder builder;
+        g_variant_builder_init(&builder, G_VARIANT_TYPE_VARDICT);
+        try {
+            const auto values = [&]() {
+                trace_span span(tracer, span_handler, object_path,
+                                interface_name, changed_since_method,
+                                sender, 0);
+                return read_uncached(lock, iface, filter, cached);
+            }();
+            latency.record(phase_handler, phase_start);
+
+            auto* reply = [&]() {
+                trace_span span(tracer, span_encode, object_path,
+                                interface_name, changed_since_method,
+                                sender, 0);
+                add_properties(builder, cached, values);
+                auto* ret = g_variant_new(
+                        "(tta{sv})",
+                        static_cast<guint64>(iface.generation()),
+                        static_cast<guint64>(version), &builder);
+                span.payload_size(g_variant_get_size(ret));
+                return ret;
+            }();
+            latency.record(phase_encode, phase_start);
+            counters.bytes_out += g_variant_get_size(reply);
+
+            g_dbus_method_invocation_return_value(invocation, reply);
+            latency.record(phase_reply, phase_start);
+        } catch (std::exception& e) {
+            for (auto& x: cached)
+                g_variant_unref(x.value);
+            g_variant_builder_clear(&builder);
+            return_error(invocation, G_DBUS_ERROR_FAILED, e.what());
+        }
+    }
+
     // C-style GDBus callbacks
     static void gdbus_method_call(
             [[maybe_unused]] GDBusConnection* connection,
-            [[maybe_unused]] const gchar* sender,
+            const gchar* sender,
             const gchar* object_path,
             const gchar* interface_name,
             const gchar* method_name,
             GVariant* parameters,
             GDBusMethodInvocation* invocation,
             gpointer internal_weak) {
+        IPCGULL_PROBE4_SCOPE(method__entry, method__return, object_path,
+                             interface_name, method_name, sender);
         if (auto i = static_cast<std::weak_ptr<internal>*>(
                 internal_weak)->lock()) {
-            std::lock_guard<std::recursive_mutex> lock(i->server_lock);
+            auto lock = i->lock_server();
+            const pending_call pending(*i);
+            if (g_strcmp0(interface_name, properties_interface) == 0) {
+                i->properties_call(lock, sender, object_path, method_name,
+                                   parameters, invocation);
+                return;
+            }
+            ++i->counters.method_calls;
+            const auto in_size = g_variant_get_size(parameters);
+            i->counters.bytes_in += in_size;
             auto weak_node = i->nodes.find(object_path);
             if (weak_node == i->nodes.end()) {
-                g_dbus_method_invocation_return_error(
-                        invocation, G_DBUS_ERROR,
-                        G_DBUS_ERROR_UNKNOWN_OBJECT, "Unknown object");
+                i->return_error(invocation,
+                                G_DBUS_ERROR_UNKNOWN_OBJECT,
+                                "Unknown object");
                 return;
             }
             if (auto node = weak_node->second.object.lock()) {
                 auto iface_it = node->interfaces().find(interface_name);
                 if (iface_it == node->interfaces().end()) {
-                    g_dbus_method_invocation_return_error(
-                            invocation, G_DBUS_ERROR,
-                            G_DBUS_ERROR_UNKNOWN_INTERFACE,
-                            "Unknown interface");
+                    i->return_error(invocation,
+                                    G_DBUS_ERROR_UNKNOWN_INTERFACE,
+                                    "Unknown interface");
                     return;
                 }
 
                 auto iface = iface_it->second.lock();
                 if (!iface) {
-                    g_dbus_method_invocation_return_error(
-                            invocation, G_DBUS_ERROR,
-                            G_DBUS_ERROR_UNKNOWN_INTERFACE,
-                            "Interface expired");
+                    i->return_error(invocation,
+                                    G_DBUS_ERROR_UNKNOWN_INTERFACE,
+                                    "Interface expired");
                     return;
                 }
 
                 const auto& functions = iface->functions();
                 auto f_it = functions.find(method_name);
 
+                if (f_it == functions.end() &&
+                    g_strcmp0(method_name, changed_since_method) == 0 &&
+                    serves_changed_since(*iface)) {
+                    i->get_changed_since(lock, *iface, sender,
+                                         object_path, interface_name,
+                                         parameters, invocation);
+                    return;
+                }
+
                 if (f_it == functions.end()) {
-                    g_dbus_method_invocation_return_error(
-                            invocation, G_DBUS_ERROR,
-                            G_DBUS_ERROR_UNKNOWN_METHOD,
-                            "Unknown method");
+                    i->return_error(invocation,
+                                    G_DBUS_ERROR_UNKNOWN_METHOD,
+                                    "Unknown method");
                     return;
                 }
 
+                const sender_call in_flight(
+                        i, f_it->second.cancel_on_disconnect() ?
+                           sender : nullptr);
+                const call_context context(
+                        sender ? sender : "",
+                        in_flight.token(f_it->second.timeout()));
+
+                // Skip the work if nobody is left to read the reply
+                if (context.cancelled()) {
+                    i->return_error(invocation,
+                                    G_DBUS_ERROR_TIMEOUT,
+                                    "Call cancelled");
+                    return;
+                }
+
+                auto& latency = i->latency_for(
+                        call_method, interface_name, method_name);
+                auto phase_start = std::chrono::steady_clock::now();
+
+                variant v_args;
                 try {
-                    auto v_args = i->from_gvariant(parameters);
-                    try {
-                        const auto args = std::get<variant_tuple>(v_args);
-                        const auto response = f_it->second(args);
-                        if (response.empty()) {
-                            g_dbus_method_invocation_return_value(
-                                    invocation, nullptr);
-                            return;
-                        }
-                        // Response is guaranteed to have a valid response type
-                        auto g_response = i->to_gvariant(
-                                response,
-                                variant_type::tuple(
-                                        f_it->second.return_types()));
+                    trace_span span(i->tracer, span_decode, object_path,
+                                    interface_name, method_name, sender,
+                                    in_size);
+                    v_args = i->from_gvariant(parameters);
+                } catch (std::invalid_argument& e) {
+                    i->return_error(invocation,
+                                    G_DBUS_ERROR_INVALID_SIGNATURE,
+                                    "Unimplemented argument type");
+                    return;
+                } catch (std::out_of_range& e) {
+                    i->return_error(invocation,
+                                    G_DBUS_ERROR_UNKNOWN_OBJECT,
+                                    "Invalid object path");
+                    return;
+                }
 
-                        g_dbus_method_invocation_return_value(
-                                invocation, g_response);
-                        return;
-                    } catch (std::bad_variant_access& e) {
-                        g_dbus_method_invocation_return_error(
-                                invocation, G_DBUS_ERROR,
-                                G_DBUS_ERROR_INVALID_SIGNATURE,
-                                "Invalid argument type");
-                        return;
-                    } catch (std::invalid_argument& e) {
-                        g_dbus_method_invocation_return_error(
-                                invocation, G_DBUS_ERROR,
-                                G_DBUS_ERROR_INVALID_ARGS,
-                                "Invalid arguments");
+                const auto* args = std::get_if<variant_tuple>(&v_args);
+                if (!args) {
+                    i->return_error(invocation,
+                                    G_DBUS_ERROR_INVALID_SIGNATURE,
+                                    "Invalid argument type");
+                    return;
+                }
+                latency.record(phase_decode, phase_start);
+
+                try {
+                    const auto response = [&]() {
+                        trace_span span(i->tracer, span_handler,
+                                        object_path, interface_name,
+                                        method_name, sender, in_size);
+                        call_context::scope scope(context);
+                        return f_it->second.invoke(*args);
+                    }();
+                    // A reply that was computed is sent even if the token
+                    // fired meanwhile, the caller may still be waiting
+                    latency.record(phase_handler, phase_start);
+                    if (!response) {
+                        i->return_error(invocation, response.error());
                         return;
-                    } catch (std::exception& e) {
-                        g_dbus_method_invocation_return_error(
-                                invocation, G_DBUS_ERROR,
-                                G_DBUS_ERROR_FAILED,
-                                "%s", e.what());
+                    }
+                    if (response->empty()) {
+                        latency.record(phase_encode, phase_start);
+                        g_dbus_method_invocation_return_value(
+                                invocation, nullptr);
+                        latency.record(phase_reply, phase_start);
                         return;
                     }
+                    auto* g_response = [&]() {
+                        trace_span span(i->tracer, span_encode,
+                                        object_path, interface_name,
+                                        method_name, sender, 0);
+                        // Response is guaranteed to have a valid
+                        // response type
+                        auto* ret = i->to_gvariant(
+                                *response,
+                                variant_type::tuple(
+                                        f_it->second.return_types()));
+                        span.payload_size(g_variant_get_size(ret));
+                        return ret;
+                    }();
+                    latency.record(phase_encode, phase_start);
+
+                    i->counters.bytes_out += g_variant_get_size(g_response);
+                    g_dbus_method_invocation_return_value(
+                            invocation, g_response);
+                    latency.record(phase_reply, phase_start);
+                } catch (std::bad_variant_access& e) {
+                    i->return_error(invocation,
+                                    G_DBUS_ERROR_INVALID_SIGNATURE,
+                                    "Invalid argument type");
                 } catch (std::invalid_argument& e) {
-                    g_dbus_method_invocation_return_error(
-                            invocation, G_DBUS_ERROR,
-                            G_DBUS_ERROR_INVALID_SIGNATURE,
-                            "Unimplemented argument type");
-                    return;
-                } catch (std::out_of_range& e) {
-                    g_dbus_method_invocation_return_error(
-                            invocation, G_DBUS_ERROR,
-                            G_DBUS_ERROR_UNKNOWN_OBJECT,
-                            "Invalid object path");
+                    i->return_error(invocation,
+                                    G_DBUS_ERROR_INVALID_ARGS,
+                                    "Invalid arguments");
+                } catch (call_cancelled& e) {
+                    i->return_error(invocation,
+                                    G_DBUS_ERROR_TIMEOUT,
+                                    e.what());
+                } catch (std::exception& e) {
+                    i->return_error(invocation,
+                                    G_DBUS_ERROR_FAILED,
+                                    e.what());
                 }
             } else {
                 // This shouldn't happen, but handle the case it does.
-                g_dbus_method_invocation_return_error(
-                        invocation, G_DBUS_ERROR,
-                        G_DBUS_ERROR_UNKNOWN_OBJECT,
-                        "Object no longer exists");
+                i->return_error(invocation,
+                                G_DBUS_ERROR_UNKNOWN_OBJECT,
+                                "Object no longer exists");
                 return;
             }
         } else {
@@ -414,150 +1371,101 @@ struct server::internal {
         }
     }
 
-    static GVariant* gdbus_get_property(
-            [[maybe_unused]] GDBusConnection* connection,
-            [[maybe_unused]] const gchar* sender,
-            const gchar* object_path,
-            const gchar* interface_name,
-            const gchar* property_name,
-            GError** error,
-            gpointer internal_weak) {
-        if (auto i = static_cast<std::weak_ptr<internal>*>(
-                internal_weak)->lock()) {
-            std::lock_guard<std::recursive_mutex> lock(i->server_lock);
-            auto weak_node = i->nodes.find(object_path);
-            if (weak_node == i->nodes.end()) {
-                g_set_error(error, G_DBUS_ERROR,
-                            G_DBUS_ERROR_UNKNOWN_OBJECT,
-                            "Unknown object");
-                return nullptr;
-            }
-            if (auto node = weak_node->second.object.lock()) {
-                auto iface_it = node->interfaces().find(interface_name);
-                if (iface_it == node->interfaces().end()) {
-                    g_set_error(error, G_DBUS_ERROR,
-                                G_DBUS_ERROR_UNKNOWN_INTERFACE,
-                                "Unknown interface");
-                    return nullptr;
-                }
-                auto iface = iface_it->second.lock();
-                if (!iface) {
-                    g_set_error(error, G_DBUS_ERROR,
-                                G_DBUS_ERROR_UNKNOWN_INTERFACE,
-                                "Interface expired");
-                    return nullptr;
-                }
-
-                try {
-                    const auto& property = iface->get_property(
-                            property_name);
-
-                    return i->to_gvariant(property.get_variant(),
-                                          property.type());
-                } catch (std::out_of_range& e) {
-                    g_set_error(error, G_DBUS_ERROR,
-                                G_DBUS_ERROR_UNKNOWN_PROPERTY,
-                                "Unknown property");
-                    return nullptr;
-                } catch (std::exception& e) {
-                    g_set_error(error, G_DBUS_ERROR,
-                                G_DBUS_ERROR_FAILED,
-                                "%s", e.what());
-                    return nullptr;
-                }
-
-            } else {
-                // This shouldn't happen, but handle the case it does.
-                g_set_error(error, G_DBUS_ERROR,
-                            G_DBUS_ERROR_UNKNOWN_OBJECT,
-                            "Object no longer exists");
-                return nullptr;
-            }
-        } else {
-            g_set_error(error, G_DBUS_ERROR,
-                        G_DBUS_ERROR_FAILED,
-                        "Internal error");
-            assert(!"method call on non-existent server");
-            return nullptr;
-        }
-    }
-
     static gboolean gdbus_set_property(
             [[maybe_unused]] GDBusConnection* connection,
-            [[maybe_unused]] const gchar* sender,
+            const gchar* sender,
             const gchar* object_path,
             const gchar* interface_name,
             const gchar* property_name,
             GVariant* value,
             GError** error,
             gpointer internal_weak) {
+        IPCGULL_PROBE4_SCOPE(property__set__entry, property__set__return,
+                             object_path, interface_name, property_name,
+                             sender);
         if (auto i = static_cast<std::weak_ptr<internal>*>(
                 internal_weak)->lock()) {
-            std::lock_guard<std::recursive_mutex> lock(i->server_lock);
+            auto lock = i->lock_server();
+            const pending_call pending(*i);
+            ++i->counters.property_sets;
+            const auto in_size = g_variant_get_size(value);
+            i->counters.bytes_in += in_size;
             auto weak_node = i->nodes.find(object_path);
             if (weak_node == i->nodes.end()) {
-                g_set_error(error, G_DBUS_ERROR,
-                            G_DBUS_ERROR_UNKNOWN_OBJECT,
-                            "Unknown object");
+                i->set_error(error,
+                             G_DBUS_ERROR_UNKNOWN_OBJECT,
+                             "Unknown object");
                 return false;
             }
             if (auto node = weak_node->second.object.lock()) {
                 auto iface_it = node->interfaces().find(interface_name);
                 if (iface_it == node->interfaces().end()) {
-                    g_set_error(error, G_DBUS_ERROR,
-                                G_DBUS_ERROR_UNKNOWN_INTERFACE,
-                                "Unknown interface");
+                    i->set_error(error,
+                                 G_DBUS_ERROR_UNKNOWN_INTERFACE,
+                                 "Unknown interface");
                     return false;
                 }
 
                 auto iface = iface_it->second.lock();
                 if (!iface) {
-                    g_set_error(error, G_DBUS_ERROR,
-                                G_DBUS_ERROR_UNKNOWN_INTERFACE,
-                                "Interface expired");
+                    i->set_error(error,
+                                 G_DBUS_ERROR_UNKNOWN_INTERFACE,
+                                 "Interface expired");
                     return false;
                 }
 
+                auto* p = iface->find_property(property_name);
+                if (!p) {
+                    i->set_error(error,
+                                 G_DBUS_ERROR_UNKNOWN_PROPERTY,
+                                 "Unknown property");
+                    return false;
+                }
+
+                auto& latency = i->latency_for(
+                        call_set_property, interface_name, property_name);
+                auto phase_start = std::chrono::steady_clock::now();
+                variant v_value;
                 try {
-                    auto& p = iface->get_property(
-                            property_name);
+                    trace_span span(i->tracer, span_decode,
+                                    object_path, interface_name,
+                                    property_name, sender, in_size);
+                    v_value = i->from_gvariant(value);
+                } catch (std::invalid_argument& e) {
+                    i->set_error(error,
+                                 G_DBUS_ERROR_INVALID_SIGNATURE,
+                                 "Unimplemented argument type");
+                    return false;
+                } catch (std::out_of_range& e) {
+                    i->set_error(error,
+                                 G_DBUS_ERROR_UNKNOWN_OBJECT,
+                                 "Invalid object path");
+                    return false;
+                }
+                latency.record(phase_decode, phase_start);
 
-                    try {
-                        return p.set_variant(i->from_gvariant(value));
-                    } catch (std::bad_variant_access& e) {
-                        g_set_error(error, G_DBUS_ERROR,
-                                    G_DBUS_ERROR_INVALID_SIGNATURE,
-                                    "Invalid argument type");
-                        return false;
-                    } catch (permission_denied& e) {
-                        g_set_error(error, G_DBUS_ERROR,
-                                    G_DBUS_ERROR_PROPERTY_READ_ONLY,
-                                    "%s", e.what());
-                        return false;
-                    } catch (std::invalid_argument& e) {
-                        g_set_error(error, G_DBUS_ERROR,
-                                    G_DBUS_ERROR_INVALID_ARGS,
-                                    "%s", e.what());
-                        return false;
-                    } catch (std::exception& e) {
-                        g_set_error(error, G_DBUS_ERROR,
-                                    G_DBUS_ERROR_FAILED,
-                                    "%s", e.what());
+                try {
+                    const auto ret = [&]() {
+                        trace_span span(i->tracer, span_handler,
+                                        object_path, interface_name,
+                                        property_name, sender, in_size);
+                        return p->try_set_variant(v_value);
+                    }();
+                    latency.record(phase_handler, phase_start);
+                    if (!ret) {
+                        i->set_error(error, ret.error());
                         return false;
                     }
-
-                } catch (std::out_of_range& e) {
-                    g_set_error(error, G_DBUS_ERROR,
-                                G_DBUS_ERROR_UNKNOWN_PROPERTY,
-                                "Unknown property");
+                    return true;
+                } catch (std::exception& e) {
+                    i->set_error(error, G_DBUS_ERROR_FAILED, e.what());
                     return false;
                 }
-
             } else {
                 // This shouldn't happen, but handle the case it does.
-                g_set_error(error, G_DBUS_ERROR,
-                            G_DBUS_ERROR_UNKNOWN_OBJECT,
-                            "Object no longer exists");
+                i->set_error(error,
+                             G_DBUS_ERROR_UNKNOWN_OBJECT,
+                             "Object no longer exists");
                 return false;
             }
         } else {
@@ -573,6 +1481,7 @@ struct server::internal {
             [[maybe_unused]] GDBusConnection* connection,
             [[maybe_unused]] const gchar* name,
             gpointer internal_weak) {
+        IPCGULL_PROBE1(name__acquired, name);
         if (auto i = static_cast<std::weak_ptr<internal>*>(
                 internal_weak)->lock()) {
             i->owns_name = NAME_OWNED;
@@ -585,6 +1494,7 @@ struct server::internal {
             [[maybe_unused]] GDBusConnection* connection,
             [[maybe_unused]] const gchar* name,
             gpointer internal_weak) {
+        IPCGULL_PROBE1(name__lost, name);
         if (auto i = static_cast<std::weak_ptr<internal>*>(
                 internal_weak)->lock()) {
             i->owns_name = NAME_LOST;
@@ -604,6 +1514,442 @@ struct server::internal {
         delete ptr;
     }
 
+    void queue_property_changed(const std::shared_ptr<internal>& self,
+                                std::string path, std::string iface,
+                                const std::string& property) {
+        std::lock_guard<std::mutex> lock(changes_lock);
+        changes[{std::move(path), std::move(iface)}].insert(property);
+        if (changes_source)
+            return;
+
+        auto* weak = new std::weak_ptr<internal>(self);
+        if (changes_window.count() > 0) {
+            changes_source = g_timeout_add_full(
+                    G_PRIORITY_DEFAULT,
+                    static_cast<guint>(changes_window.count()),
+                    flush_properties_changed, weak, free_internal_weak);
+        } else {
+            // Default priority so a busy loop cannot starve it
+            changes_source = g_idle_add_full(
+                    G_PRIORITY_DEFAULT, flush_properties_changed,
+                    weak, free_internal_weak);
+        }
+    }
+
+    static gboolean flush_properties_changed(gpointer internal_weak) {
+        if (auto i = static_cast<std::weak_ptr<internal>*>(
+                internal_weak)->lock()) {
+            decltype(i->changes) pending;
+            {
+                std::lock_guard<std::mutex> lock(i->changes_lock);
+                pending.swap(i->changes);
+                i->changes_source = 0;
+            }
+
+            auto lock = i->lock_server();
+            for (auto& x: pending)
+                i->emit_properties_changed(lock, x.first.first,
+                                           x.first.second, x.second);
+        }
+
+        return G_SOURCE_REMOVE;
+    }
+
+    // Reads the latest values, so any number of changes to a property
+    // since the last flush produce a single entry
+    void emit_properties_changed(
+            std::unique_lock<std::recursive_mutex>& lock,
+            const std::string& path, const std::string& if_name,
+            const std::set<std::string>& properties) {
+        if (!connection)
+            return;
+        auto node_it = nodes.find(path);
+        if (node_it == nodes.end())
+            return;
+        auto n = node_it->second.object.lock();
+        if (!n)
+            return;
+        auto if_it = n->interfaces().find(if_name);
+        if (if_it == n->interfaces().end())
+            return;
+        auto iface = if_it->second.lock();
+        if (!iface)
+            return;
+
+        GVariantBuilder changed;
+        GVariantBuilder invalidated;
+        g_variant_builder_init(&changed, G_VARIANT_TYPE_VARDICT);
+        g_variant_builder_init(&invalidated, G_VARIANT_TYPE_STRING_ARRAY);
+
+        // Read together so that a transaction is never seen half-applied.
+        // Encodings are cached for the clients reading the values back.
+        std::vector<cached_property> cached;
+        std::vector<interface::property_value> values;
+        try {
+            values = read_uncached(lock, *iface, [&properties, &iface](
+                    const std::string& name) {
+                if (!properties.count(name))
+                    return false;
+                // Container deltas went out as their own signal
+                return !iface->find_property(name)->delta_signal();
+            }, cached);
+        } catch (std::exception& e) {
+            for (auto& x: cached)
+                g_variant_unref(x.value);
+            cached.clear();
+            for (auto& name: properties) {
+                const auto* p = iface->find_property(name);
+                if (p && (p->permissions() & property_readable))
+                    g_variant_builder_add(&invalidated, "s", name.c_str());
+            }
+        }
+
+        for (auto& name: properties) {
+            const auto* p = iface->find_property(name);
+            if (p && p->delta_signal() &&
+                (p->permissions() & property_readable))
+                g_variant_builder_add(&invalidated, "s", name.c_str());
+        }
+
+        for (auto& x: cached) {
+            g_variant_builder_add(&changed, "{sv}", x.name->c_str(),
+                                  x.value);
+            g_variant_unref(x.value);
+        }
+
+        for (auto& x: values) {
+            GVariant* g_value;
+            try {
+                g_value = cache_gvariant(
+                        *x.property, x.version, x.value,
+                        to_gvariant(x.value, x.property->type()));
+            } catch (std::exception& e) {
+                g_variant_builder_add(&invalidated, "s", x.name->c_str());
+                continue;
+            }
+            g_variant_builder_add(&changed, "{sv}", x.name->c_str(),
+                                  g_value);
+            g_variant_unref(g_value);
+        }
+
+        auto* g_args = g_variant_ref_sink(g_variant_new(
+                "(sa{sv}as)", if_name.c_str(), &changed, &invalidated));
+        // server_lock was released for the read
+        if (!connection) {
+            g_variant_unref(g_args);
+            return;
+        }
+
+        trace_span span(tracer, span_signal_emit, path.c_str(),
+                        "org.freedesktop.DBus.Properties",
+                        "PropertiesChanged", nullptr,
+                        g_variant_get_size(g_args));
+        IPCGULL_PROBE4(signal__emit, path.c_str(),
+                       "org.freedesktop.DBus.Properties",
+                       "PropertiesChanged", g_variant_get_size(g_args));
+
+        ++counters.signals;
+        counters.bytes_out += g_variant_get_size(g_args);
+        roll_signal_window();
+        ++signal_window_count;
+
+        g_dbus_connection_emit_signal(
+                connection, nullptr, path.c_str(),
+                "org.freedesktop.DBus.Properties", "PropertiesChanged",
+                g_args, nullptr);
+        g_variant_unref(g_args);
+    }
+
+    // Returns a new reference, marshalling the payload if it was not yet
+    GVariant* payload_gvariant(const signal_payload& payload) {
+        auto& data = payload.raw_data();
+        if (!data.server_independent)
+            return g_variant_ref_sink(to_gvariant(data.args,
+                                                  data.args_type));
+
+        std::call_once(data.marshalled, [this, &data]() {
+            data.value = g_variant_ref_sink(to_gvariant(data.args,
+                                                        data.args_type));
+        });
+        return g_variant_ref(data.value);
+    }
+
+    // Sends a signal to each destination, or broadcasts it if there are
+    // none. server_lock must be held.
+    void send_signal(const std::string& node, const std::string& iface,
+                     const std::string& signal,
+                     const signal_payload& payload,
+                     const std::vector<std::string>& destinations) {
+        auto* g_args = payload_gvariant(payload);
+
+        trace_span span(tracer, span_signal_emit, node.c_str(),
+                        iface.c_str(), signal.c_str(), nullptr,
+                        g_variant_get_size(g_args));
+        IPCGULL_PROBE4(signal__emit, node.c_str(), iface.c_str(),
+                       signal.c_str(), g_variant_get_size(g_args));
+
+        const auto send = [&](const gchar* destination) {
+            ++counters.signals;
+            counters.bytes_out += g_variant_get_size(g_args);
+            roll_signal_window();
+            ++signal_window_count;
+
+            GError* error = nullptr;
+            if (!g_dbus_connection_emit_signal(
+                    connection, destination,
+                    node.c_str(), iface.c_str(),
+                    signal.c_str(), g_args, &error)) {
+                if (error) {
+                    g_variant_unref(g_args);
+                    const std::string ewhat(error->message);
+                    g_clear_error(&error);
+                    throw std::runtime_error(ewhat);
+                }
+            }
+        };
+
+        if (destinations.empty()) {
+            send(nullptr);
+        } else {
+            for (auto& x: destinations)
+                send(x.c_str());
+        }
+
+        g_variant_unref(g_args);
+    }
+
+    // True if the signal should be sent now. Otherwise it is dropped, or
+    // with coalesce_latest held back until a flush sends the latest args.
+    bool throttle_signal(const std::shared_ptr<internal>& self,
+                         const std::string& node, const std::string& iface,
+                         const std::string& signal,
+                         const signal_payload& payload,
+                         const signal_policy& policy,
+                         const std::vector<std::string>& destinations) {
+        std::string joined;
+        for (auto& x: destinations) {
+            if (!joined.empty())
+                joined += ',';
+            joined += x;
+        }
+        signal_key key{node, iface, signal, std::move(joined)};
+
+        const auto now = std::chrono::steady_clock::now();
+        std::lock_guard<std::mutex> lock(throttle_lock);
+        sweep_throttled(now);
+        auto& t = throttled[key];
+        switch (t.throttle.emit(policy, now, payload)) {
+            case signal_throttle<signal_payload>::throttle_send:
+                return true;
+            case signal_throttle<signal_payload>::throttle_drop:
+                ++counters.signals_dropped;
+                return false;
+            case signal_throttle<signal_payload>::throttle_coalesce:
+                ++counters.signals_coalesced;
+                return false;
+            case signal_throttle<signal_payload>::throttle_hold:
+                return false;
+            case signal_throttle<signal_payload>::throttle_schedule:
+                break;
+        }
+
+        t.policy = policy;
+        t.destinations = destinations;
+        t.source = start_throttle_timer(self, std::move(key),
+                                        t.throttle.delay());
+        return false;
+    }
+
+    static guint start_throttle_timer(const std::weak_ptr<internal>& self,
+                                      signal_key key,
+                                      std::chrono::steady_clock::duration
+                                      delay) {
+        auto* data = new throttle_flush{self, std::move(key)};
+        if (delay > std::chrono::steady_clock::duration::zero()) {
+            const auto ms = std::min<std::chrono::milliseconds::rep>(
+                    std::chrono::ceil<std::chrono::milliseconds>(
+                            delay).count(),
+                    std::numeric_limits<guint>::max());
+            return g_timeout_add_full(
+                    G_PRIORITY_DEFAULT, static_cast<guint>(ms),
+                    flush_throttled, data, free_throttle_flush);
+        }
+        return g_idle_add_full(G_PRIORITY_DEFAULT, flush_throttled,
+                               data, free_throttle_flush);
+    }
+
+    // Forgets signals whose throttling no longer has any effect, so that
+    // unicasts to many peers do not grow the map without bound. Amortized
+    // O(1) per emission; throttle_lock must be held.
+    void sweep_throttled(std::chrono::steady_clock::time_point now) {
+        if (throttled.size() < throttle_sweep_at)
+            return;
+        for (auto it = throttled.begin(); it != throttled.end();) {
+            if (it->second.throttle.idle(now))
+                it = throttled.erase(it);
+            else
+                ++it;
+        }
+        throttle_sweep_at = std::max<std::size_t>(64, throttled.size() * 2);
+    }
+
+    static void free_throttle_flush(gpointer user_data) {
+        delete static_cast<throttle_flush*>(user_data);
+    }
+
+    static gboolean flush_throttled(gpointer user_data) {
+        auto* flush = static_cast<throttle_flush*>(user_data);
+        if (auto i = flush->i.lock()) {
+            std::optional<signal_payload> payload;
+            std::vector<std::string> destinations;
+            {
+                std::lock_guard<std::mutex> lock(i->throttle_lock);
+                auto it = i->throttled.find(flush->key);
+                if (it == i->throttled.end())
+                    return G_SOURCE_REMOVE;
+
+                auto& t = it->second;
+                const auto now = std::chrono::steady_clock::now();
+                payload = t.throttle.fire(t.policy, now);
+                t.source = 0;
+                if (payload)
+                    destinations = t.destinations;
+                if (t.throttle.timer_running())
+                    t.source = start_throttle_timer(i, flush->key,
+                                                    t.throttle.delay());
+                else if (t.throttle.idle(now))
+                    i->throttled.erase(it);
+            }
+
+            if (!payload)
+                return G_SOURCE_REMOVE;
+
+            auto lock = i->lock_server();
+            try {
+                i->send_signal(std::get<0>(flush->key),
+                               std::get<1>(flush->key),
+                               std::get<2>(flush->key), *payload,
+                               destinations);
+            } catch (std::exception& e) {
+                ++i->counters.errors;
+            }
+        }
+
+        return G_SOURCE_REMOVE;
+    }
+
+    // Stops the pending flushes of an interface's signals
+    void forget_throttled(const std::string& node, const std::string& iface) {
+        std::lock_guard<std::mutex> lock(throttle_lock);
+        auto it = throttled.lower_bound(
+                {node, iface, std::string(), std::string()});
+        while (it != throttled.end() && std::get<0>(it->first) == node &&
+               std::get<1>(it->first) == iface) {
+            if (it->second.source)
+                g_source_remove(it->second.source);
+            it = throttled.erase(it);
+        }
+    }
+
+    bool loop_running() const {
+        GMainLoop* loop = main_loop;
+        return loop && g_main_loop_is_running(loop);
+    }
+
+    void notify_drained() {
+        {
+            std::lock_guard<std::mutex> lock(drain_lock);
+            ++drain_count;
+        }
+        drained.notify_all();
+    }
+
+    void queue_signal(const std::shared_ptr<internal>& self,
+                      const std::shared_ptr<signal_ring>& queue,
+                      std::unique_ptr<queued_signal> record,
+                      signal_overflow overflow) {
+        while (!queue->try_push(record)) {
+            if (overflow == overflow_drop_newest) {
+                ++counters.signals_dropped;
+                return;
+            } else if (overflow == overflow_drop_oldest) {
+                std::unique_ptr<queued_signal> oldest;
+                if (queue->try_pop(oldest))
+                    ++counters.signals_dropped;
+            } else if (!loop_running() || g_main_context_is_owner(nullptr) ||
+                       std::atomic_load(&signal_queue) != queue) {
+                // Nobody else would drain it
+                auto lock = lock_server();
+                drain_signals(*queue, queue->capacity());
+            } else {
+                std::unique_lock<std::mutex> lock(drain_lock);
+                const auto seen = drain_count;
+                schedule_signal_drain(self);
+                // Timed, so that the loop stopping is noticed
+                drained.wait_for(lock, std::chrono::milliseconds(10),
+                                 [this, seen]() {
+                                     return drain_count != seen;
+                                 });
+            }
+        }
+
+        // A queue replaced by set_signal_queue() is no longer drained by
+        // the loop, and may have been drained before this push
+        if (std::atomic_load(&signal_queue) != queue) {
+            auto lock = lock_server();
+            drain_signals(*queue, queue->capacity());
+            return;
+        }
+
+        schedule_signal_drain(self);
+    }
+
+    void schedule_signal_drain(const std::shared_ptr<internal>& self) {
+        if (signal_drain_scheduled.exchange(true))
+            return;
+        g_idle_add_full(G_PRIORITY_DEFAULT, flush_signals,
+                        new std::weak_ptr<internal>(self),
+                        free_internal_weak);
+    }
+
+    static gboolean flush_signals(gpointer internal_weak) {
+        if (auto i = static_cast<std::weak_ptr<internal>*>(
+                internal_weak)->lock()) {
+            i->signal_drain_scheduled = false;
+            auto queue = std::atomic_load(&i->signal_queue);
+            if (!queue)
+                return G_SOURCE_REMOVE;
+
+            auto lock = i->lock_server();
+            // Bounded so busy emitters cannot starve the loop
+            if (!i->drain_signals(*queue, queue->capacity()))
+                i->schedule_signal_drain(i);
+        }
+
+        return G_SOURCE_REMOVE;
+    }
+
+    // Sends up to limit queued signals, returns false if some are left
+    bool drain_signals(signal_ring& queue, std::size_t limit) {
+        std::unique_ptr<queued_signal> x;
+        bool empty = false;
+        for (std::size_t n = 0; n < limit; ++n) {
+            if (!queue.try_pop(x)) {
+                empty = true;
+                break;
+            }
+            try {
+                send_signal(x->node, x->iface, x->signal, x->payload,
+                            x->destinations);
+            } catch (std::exception& e) {
+                ++counters.errors;
+            }
+        }
+
+        notify_drained();
+        return empty;
+    }
+
     static GDBusArgInfo* arg_info(const std::string& name,
                                   const variant_type& type) {
         auto* info = g_new(GDBusArgInfo, 1);
@@ -658,6 +2004,50 @@ struct server::internal {
         return info;
     }
 
+    static constexpr const gchar* changed_since_method = "GetChangedSince";
+
+    // Added to interfaces with readable properties unless they define a
+    // method of the same name
+    static bool serves_changed_since(const interface& iface) {
+        if (iface.functions().count(changed_since_method))
+            return false;
+        return std::any_of(iface.properties().begin(),
+                           iface.properties().end(), [](auto& x) {
+                    return x.second.permissions() & property_readable;
+                });
+    }
+
+    static GDBusArgInfo* raw_arg_info(const gchar* name,
+                                      const gchar* signature) {
+        auto* info = g_new(GDBusArgInfo, 1);
+        assert(info);
+        info->ref_count = 1;
+        info->name = g_strdup(name);
+        info->signature = g_strdup(signature);
+        info->annotations = nullptr;
+        return info;
+    }
+
+    // GetChangedSince(t generation, t since)
+    //     -> (t generation, t version, a{sv} changed)
+    static GDBusMethodInfo* changed_since_info() {
+        auto* info = g_new(GDBusMethodInfo, 1);
+        assert(info);
+        info->ref_count = 1;
+        info->name = g_strdup(changed_since_method);
+        info->annotations = nullptr;
+        info->in_args = g_new(GDBusArgInfo*, 3);
+        info->in_args[0] = raw_arg_info("generation", "t");
+        info->in_args[1] = raw_arg_info("since", "t");
+        info->in_args[2] = nullptr;
+        info->out_args = g_new(GDBusArgInfo*, 4);
+        info->out_args[0] = raw_arg_info("generation", "t");
+        info->out_args[1] = raw_arg_info("version", "t");
+        info->out_args[2] = raw_arg_info("changed", "a{sv}");
+        info->out_args[3] = nullptr;
+        return info;
+    }
+
     static GDBusPropertyInfo* property_info(const std::string& name,
                                             const base_property& p) {
         auto* info = g_new(GDBusPropertyInfo, 1);
@@ -665,6 +2055,18 @@ struct server::internal {
         info->ref_count = 1;
         info->name = g_strdup(name.c_str());
         info->annotations = nullptr;
+        if (p.delta_signal()) {
+            auto* annotation = g_new(GDBusAnnotationInfo, 1);
+            assert(annotation);
+            annotation->ref_count = 1;
+            annotation->key = g_strdup(
+                    "org.freedesktop.DBus.Property.EmitsChangedSignal");
+            annotation->value = g_strdup("invalidates");
+            annotation->annotations = nullptr;
+            info->annotations = g_new(GDBusAnnotationInfo*, 2);
+            info->annotations[0] = annotation;
+            info->annotations[1] = nullptr;
+        }
         {
             int flags = G_DBUS_PROPERTY_INFO_FLAGS_NONE;
             if (p.permissions() & property_readable)
@@ -713,13 +2115,14 @@ struct server::internal {
 
         {
             const auto& functions = iface.functions();
-            if (functions.empty()) {
+            const bool sync = serves_changed_since(iface);
+            const auto count = functions.size() + sync;
+            if (!count) {
                 info->methods = nullptr;
             } else {
-                info->methods = g_new(GDBusMethodInfo*,
-                                      functions.size() + 1);
+                info->methods = g_new(GDBusMethodInfo*, count + 1);
                 assert(info->methods);
-                info->methods[functions.size()] = nullptr;
+                info->methods[count] = nullptr;
             }
 
             std::size_t i = 0;
@@ -727,6 +2130,8 @@ struct server::internal {
                 info->methods[i] = function_info(x.first, x.second);
                 ++i;
             }
+            if (sync)
+                info->methods[i] = changed_since_info();
         }
 
         {
@@ -772,10 +2177,128 @@ struct server::internal {
 
     static constexpr GDBusInterfaceVTable interface_vtable = {
             .method_call = gdbus_method_call,
-            .get_property = gdbus_get_property,
+            // Unset so Properties.Get and GetAll reach gdbus_method_call
+            .get_property = nullptr,
             .set_property = gdbus_set_property,
             .padding = {}
     };
+
+    struct stats_property {
+        const gchar* name;
+        const gchar* signature;
+
+        GVariant* (* get)(const server_stats&);
+    };
+
+    static const std::vector<stats_property>& stats_properties() {
+        static const std::vector<stats_property> properties = {
+                {"MethodCalls",     "t", [](const server_stats& s) {
+                    return g_variant_new_uint64(s.method_calls);
+                }},
+                {"PropertyGets",    "t", [](const server_stats& s) {
+                    return g_variant_new_uint64(s.property_gets);
+                }},
+                {"PropertySets",    "t", [](const server_stats& s) {
+                    return g_variant_new_uint64(s.property_sets);
+                }},
+                {"Errors",          "t", [](const server_stats& s) {
+                    return g_variant_new_uint64(s.errors);
+                }},
+                {"BytesIn",         "t", [](const server_stats& s) {
+                    return g_variant_new_uint64(s.bytes_in);
+                }},
+                {"BytesOut",        "t", [](const server_stats& s) {
+                    return g_variant_new_uint64(s.bytes_out);
+                }},
+                {"SignalsEmitted",  "t", [](const server_stats& s) {
+                    return g_variant_new_uint64(s.signals_emitted);
+                }},
+                {"SignalsDropped",  "t", [](const server_stats& s) {
+                    return g_variant_new_uint64(s.signals_dropped);
+                }},
+                {"SignalsCoalesced", "t", [](const server_stats& s) {
+                    return g_variant_new_uint64(s.signals_coalesced);
+                }},
+                {"SignalRate",      "t", [](const server_stats& s) {
+                    return g_variant_new_uint64(s.signal_rate);
+                }},
+                {"PendingCalls",    "t", [](const server_stats& s) {
+                    return g_variant_new_uint64(s.pending_calls);
+                }},
+                {"LockWaitTotalNs", "t", [](const server_stats& s) {
+                    return g_variant_new_uint64(s.lock_wait_total.count());
+                }},
+                {"LockWaitMaxNs",   "t", [](const server_stats& s) {
+                    return g_variant_new_uint64(s.lock_wait_max.count());
+                }},
+                {"Objects",         "t", [](const server_stats& s) {
+                    return g_variant_new_uint64(s.objects);
+                }},
+                {"Interfaces",      "t", [](const server_stats& s) {
+                    return g_variant_new_uint64(s.interfaces);
+                }}
+        };
+
+        return properties;
+    }
+
+    static GDBusInterfaceInfo* stats_interface_info() {
+        const auto& properties = stats_properties();
+        auto* info = g_new(GDBusInterfaceInfo, 1);
+        assert(info);
+        info->ref_count = 1;
+        info->annotations = nullptr;
+        info->name = g_strdup(stats_interface);
+        info->methods = nullptr;
+        info->signals = nullptr;
+        info->properties = g_new(GDBusPropertyInfo*, properties.size() + 1);
+        assert(info->properties);
+        info->properties[properties.size()] = nullptr;
+
+        for (std::size_t i = 0; i < properties.size(); ++i) {
+            auto* p_info = g_new(GDBusPropertyInfo, 1);
+            assert(p_info);
+            p_info->ref_count = 1;
+            p_info->name = g_strdup(properties[i].name);
+            p_info->signature = g_strdup(properties[i].signature);
+            p_info->flags = G_DBUS_PROPERTY_INFO_FLAGS_READABLE;
+            p_info->annotations = nullptr;
+            info->properties[i] = p_info;
+        }
+
+        return info;
+    }
+
+    static GVariant* gdbus_get_stats_property(
+            [[maybe_unused]] GDBusConnection* connection,
+            [[maybe_unused]] const gchar* sender,
+            [[maybe_unused]] const gchar* object_path,
+            [[maybe_unused]] const gchar* interface_name,
+            const gchar* property_name,
+            GError** error,
+            gpointer internal_weak) {
+        if (auto i = static_cast<std::weak_ptr<internal>*>(
+                internal_weak)->lock()) {
+            for (auto& x: stats_properties()) {
+                if (g_strcmp0(x.name, property_name) == 0)
+                    return x.get(i->stats());
+            }
+        }
+
+        g_set_error(error, G_DBUS_ERROR,
+                    G_DBUS_ERROR_UNKNOWN_PROPERTY,
+                    "Unknown property");
+        return nullptr;
+    }
+
+    static constexpr const gchar* stats_interface = "org.ipcgull.Stats";
+
+    static constexpr GDBusInterfaceVTable stats_vtable = {
+            .method_call = nullptr,
+            .get_property = gdbus_get_stats_property,
+            .set_property = nullptr,
+            .padding = {}
+    };
 };
 
 
@@ -835,6 +2358,8 @@ server::server(std::string name,
     g_dbus_object_manager_server_set_connection(_internal->object_manager,
                                                 _internal->connection);
 
+    internal::watch_senders(_internal);
+
     // Only set server_exists on completion
     server_exists = true;
 }
@@ -853,6 +2378,22 @@ server::~server() {
     if (running())
         stop_sync();
 
+    {
+        std::lock_guard<std::mutex> lock(_internal->changes_lock);
+        if (_internal->changes_source)
+            g_source_remove(_internal->changes_source);
+        _internal->changes_source = 0;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(_internal->throttle_lock);
+        for (auto& x: _internal->throttled) {
+            if (x.second.source)
+                g_source_remove(x.second.source);
+        }
+        _internal->throttled.clear();
+    }
+
     for (auto& x: _internal->nodes) {
         if (auto n = x.second.object.lock())
             n->drop_server(_self);
@@ -874,6 +2415,10 @@ server::~server() {
         g_bus_unown_name(_internal->gdbus_name);
 
     if (_internal->connection) {
+        if (_internal->stats_registration)
+            g_dbus_connection_unregister_object(
+                    _internal->connection, _internal->stats_registration);
+        _internal->forget_senders();
         g_dbus_connection_close_sync(_internal->connection, nullptr, nullptr);
         g_object_unref(_internal->connection);
     }
@@ -881,26 +2426,27 @@ server::~server() {
 
 void server::emit_signal(
         const std::string& node, const std::string& iface,
-        const std::string& signal, const variant_tuple& args,
-        const variant_type& args_type) const {
-    std::lock_guard<std::recursive_mutex> lock(_internal->server_lock);
-    auto* g_args = g_variant_ref_sink(_internal->to_gvariant(args, args_type));
-    GError* error = nullptr;
+        const std::string& signal, const signal_payload& payload,
+        const signal_policy& policy,
+        const std::vector<std::string>& destinations) const {
+    if (policy.throttled() &&
+        !_internal->throttle_signal(_internal, node, iface, signal,
+                                    payload, policy, destinations))
+        return;
 
-    // TODO: Destination bus support
-    if (!g_dbus_connection_emit_signal(
-            _internal->connection, nullptr,
-            node.c_str(), iface.c_str(),
-            signal.c_str(), g_args, &error)) {
-        if (error) {
-            g_variant_unref(g_args);
-            const std::string ewhat(error->message);
-            g_clear_error(&error);
-            throw std::runtime_error(ewhat);
-        }
+    if (auto queue = std::atomic_load(&_internal->signal_queue)) {
+        _internal->queue_signal(
+                _internal, queue,
+                std::make_unique<internal::queued_signal>(
+                        internal::queued_signal{
+                                node, iface, signal, payload,
+                                destinations}),
+                policy.overflow);
+        return;
     }
 
-    g_variant_unref(g_args);
+    auto lock = _internal->lock_server();
+    _internal->send_signal(node, iface, signal, payload, destinations);
 }
 
 void server::add_interface(const std::shared_ptr<node>& node,
@@ -913,6 +2459,11 @@ void server::add_interface(const std::shared_ptr<node>& node,
             throw std::runtime_error("interface already exists");
     }
 
+    internal::trace_span span(_internal->tracer, span_registration,
+                              node_name.c_str(), iface.name().c_str(),
+                              nullptr, nullptr, 0);
+    IPCGULL_PROBE2(interface__add, node_name.c_str(), iface.name().c_str());
+
     auto* iface_info = internal::interface_info(iface);
     GError* error = nullptr;
     auto reg_id = g_dbus_connection_register_object(
@@ -949,8 +2500,14 @@ bool server::drop_interface(const std::string& node_path,
     if (iface_it == node_it->second.interfaces.end())
         return false;
 
+    internal::trace_span span(_internal->tracer, span_registration,
+                              node_path.c_str(), if_name.c_str(),
+                              nullptr, nullptr, 0);
+    IPCGULL_PROBE2(interface__drop, node_path.c_str(), if_name.c_str());
+
     ret = g_dbus_connection_unregister_object(_internal->connection,
                                               iface_it->second);
+    _internal->forget_throttled(node_path, if_name);
 
     node_it->second.interfaces.erase(iface_it);
     if (node_it->second.interfaces.empty()) {
@@ -963,6 +2520,12 @@ bool server::drop_interface(const std::string& node_path,
     return ret;
 }
 
+void server::property_changed(const std::string& node,
+                              const std::string& iface,
+                              const std::string& property) {
+    _internal->queue_property_changed(_internal, node, iface, property);
+}
+
 void server::set_managing(const std::shared_ptr<node>& n,
                           const std::weak_ptr<object>& managing) {
     std::lock_guard<std::recursive_mutex> lock(_internal->server_lock);
@@ -985,6 +2548,7 @@ void server::set_managing(const std::shared_ptr<node>& n,
         return;
     std::lock_guard<std::mutex> lock(_internal->run_lock);
     GError* err = nullptr;
+    bool stats_exported = false;
 
     if (_internal->connection) {
         if (g_dbus_connection_is_closed(_internal->connection)) {
@@ -992,7 +2556,22 @@ void server::set_managing(const std::shared_ptr<node>& n,
                 g_dbus_object_manager_server_set_connection(
                         _internal->object_manager, nullptr);
 
+            {
+                // Registered again on the new connection below
+                std::lock_guard<std::recursive_mutex> registration_lock(
+                        _internal->server_lock);
+                if (_internal->stats_registration) {
+                    stats_exported = true;
+                    g_dbus_connection_unregister_object(
+                            _internal->connection,
+                            _internal->stats_registration);
+                    _internal->stats_registration = 0;
+                }
+            }
+
+            _internal->forget_senders();
             g_object_unref(_internal->connection);
+            _internal->connection = nullptr;
         }
     }
 
@@ -1015,6 +2594,8 @@ void server::set_managing(const std::shared_ptr<node>& n,
         if (!_internal->connection) {
             throw connection_failed();
         }
+
+        internal::watch_senders(_internal);
     }
 
     if (_internal->owns_name == NAME_LOST) {
@@ -1034,6 +2615,9 @@ void server::set_managing(const std::shared_ptr<node>& n,
         g_dbus_object_manager_server_set_connection(_internal->object_manager,
                                                     _internal->connection);
     }
+
+    if (stats_exported)
+        export_stats(true);
 }
 
 [[maybe_unused]] void server::start() {
@@ -1060,6 +2644,8 @@ void server::stop() {
     if (_internal->main_loop) {
         g_main_loop_quit(_internal->main_loop);
     }
+    // Emitters waiting for the loop to drain the queue now do it themselves
+    _internal->notify_drained();
 }
 
 void server::stop_wait() {
@@ -1081,19 +2667,105 @@ const std::string& server::root_node() const {
     return _root;
 }
 
+void server::set_observer(std::shared_ptr<observer> o) {
+    std::lock_guard<std::recursive_mutex> lock(_internal->server_lock);
+    _internal->tracer = o.get();
+    _internal->tracer_owner = std::move(o);
+}
+
+server_stats server::stats() const {
+    return _internal->stats();
+}
+
+void server::export_stats(bool exported) {
+    std::lock_guard<std::recursive_mutex> lock(_internal->server_lock);
+    if (exported == (_internal->stats_registration != 0))
+        return;
+
+    if (!exported) {
+        g_dbus_connection_unregister_object(_internal->connection,
+                                            _internal->stats_registration);
+        _internal->stats_registration = 0;
+        return;
+    }
+
+    auto* info = internal::stats_interface_info();
+    GError* error = nullptr;
+    auto reg_id = g_dbus_connection_register_object(
+            _internal->connection,
+            _root.c_str(),
+            info,
+            &internal::stats_vtable,
+            new std::weak_ptr<internal>(_internal),
+            internal::free_internal_weak,
+            &error);
+    g_dbus_interface_info_unref(info);
+
+    if (error) {
+        const std::string ewhat(error->message);
+        g_clear_error(&error);
+        throw std::runtime_error(ewhat);
+    }
+
+    _internal->stats_registration = reg_id;
+}
+
+latency_report server::latency() const {
+    std::lock_guard<std::recursive_mutex> lock(_internal->server_lock);
+    latency_report report;
+    for (auto& x: _internal->latency)
+        report.emplace(x.first, x.second.snapshot());
+
+    return report;
+}
+
+void server::reset_latency() {
+    std::lock_guard<std::recursive_mutex> lock(_internal->server_lock);
+    for (auto& x: _internal->latency)
+        x.second.reset();
+}
+
+void server::set_properties_changed_window(
+        std::chrono::milliseconds window) {
+    std::lock_guard<std::mutex> lock(_internal->changes_lock);
+    _internal->changes_window = window;
+}
+
+void server::set_signal_queue(std::size_t capacity) {
+    auto lock = _internal->lock_server();
+    std::shared_ptr<internal::signal_ring> queue;
+    if (capacity)
+        queue = std::make_shared<internal::signal_ring>(capacity);
+    auto old = std::atomic_exchange(&_internal->signal_queue, queue);
+    if (old)
+        _internal->drain_signals(*old, old->capacity());
+}
+
 std::string node::full_name(const server& s) const {
-    const auto tree = tree_name();
+    const auto& tree = tree_name();
     if (tree.empty())
         return s.root_node();
     else
         return s.root_node() + "/" + tree;
 }
 
-std::string node::tree_name() const {
-    std::lock_guard<std::recursive_mutex> lock(*_hierarchy_lock);
-    if (const auto parent = _parent.lock()) {
-        return parent->tree_name() + "/" + name();
-    } else {
-        return name();
-    }
+signal_payload::signal_payload(variant_tuple args, variant_type args_type) :
+        _internal(std::make_shared<internal>()) {
+    const std::vector<variant>& items = args;
+    _internal->server_independent = std::none_of(items.begin(), items.end(),
+                                                 references_objects);
+    _internal->args = std::move(args);
+    _internal->args_type = std::move(args_type);
+}
+
+const variant_tuple& signal_payload::args() const {
+    return _internal->args;
+}
+
+const variant_type& signal_payload::type() const {
+    return _internal->args_type;
+}
+
+signal_payload::internal& signal_payload::raw_data() const {
+    return *_internal;
 }
@@ -37,6 +37,11 @@ namespace ipcgull {
 
         internal() : running(false) {}
     };
+
+    struct signal_payload::internal {
+        variant_tuple args;
+        variant_type args_type;
+    };
 }
 
 variant_type::variant_type() = default;
@@ -47,6 +52,8 @@ variant_type::variant_type([[maybe_unused]] const std::type_info&) {}
 
 variant_type::variant_type([[maybe_unused]] const variant_type& o) {}
 
+variant_type::variant_type([[maybe_unused]] variant_type&& o) noexcept {}
+
 variant_type variant_type::vector(const variant_type& t) { return {}; }
 
 variant_type variant_type::map(const variant_type& k, const variant_type& v) { return {}; }
@@ -88,8 +95,9 @@ std::shared_ptr<server> server::make_server(const std::string& name,
 
 void server::emit_signal(
         const std::string& node, const std::string& iface,
-        const std::string& signal, const variant_tuple& args,
-        const variant_type& args_type) const {
+        const std::string& signal, const signal_payload& payload,
+        const signal_policy& policy,
+        const std::vector<std::string>& destinations) const {
 }
 
 void server::add_interface(const std::shared_ptr<node>& node,
@@ -101,6 +109,12 @@ bool server::drop_interface(const std::string& node_path,
     return true;
 }
 
+void server::property_changed(
+        [[maybe_unused]] const std::string& node,
+        [[maybe_unused]] const std::string& iface,
+        [[maybe_unused]] const std::string& property) {
+}
+
 void server::set_managing(const std::shared_ptr<node>& n,
                           const std::weak_ptr<object>& managing) {
 }
@@ -147,19 +161,51 @@ const std::string& server::root_node() const {
     return _root;
 }
 
+void server::set_observer([[maybe_unused]] std::shared_ptr<observer> o) {
+}
+
+server_stats server::stats() const {
+    return {};
+}
+
+void server::export_stats([[maybe_unused]] bool exported) {
+}
+
+latency_report server::latency() const {
+    return {};
+}
+
+void server::reset_latency() {
+}
+
+void server::set_properties_changed_window(
+        [[maybe_unused]] std::chrono::milliseconds window) {
+}
+
+void server::set_signal_queue([[maybe_unused]] std::size_t capacity) {
+}
+
+signal_payload::signal_payload(variant_tuple args, variant_type args_type) :
+        _internal(std::make_shared<internal>(
+                internal{std::move(args), std::move(args_type)})) {
+}
+
+const variant_tuple& signal_payload::args() const {
+    return _internal->args;
+}
+
+const variant_type& signal_payload::type() const {
+    return _internal->args_type;
+}
+
+signal_payload::internal& signal_payload::raw_data() const {
+    return *_internal;
+}
+
 std::string node::full_name(const server& s) const {
-    const auto tree = tree_name();
+    const auto& tree = tree_name();
     if (tree.empty())
         return s.root_node();
     else
         return s.root_node() + "/" + tree;
 }
-
-std::string node::tree_name() const {
-    std::lock_guard<std::recursive_mutex> lock(*_hierarchy_lock);
-    if (const auto parent = _parent.lock()) {
-        return parent->tree_name() + "/" + name();
-    } else {
-        return name();
-    }
-}
@@ -0,0 +1,117 @@
+/*
+ * Copyright 2022 PixlOne
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef IPCGULL_SIGNAL_THROTTLE_H
+#define IPCGULL_SIGNAL_THROTTLE_H
+
+#include <algorithm>
+#include <chrono>
+#include <optional>
+#include <utility>
+#include <ipcgull/signal.h>
+
+namespace ipcgull {
+    // signal_policy::min_interval and coalesce_latest for one signal. The
+    // backend owns the timer and the locking; this only decides.
+    template<typename Payload>
+    class signal_throttle {
+    public:
+        typedef std::chrono::steady_clock clock;
+
+        enum action {
+            // Send the signal now
+            throttle_send,
+            // Discard it
+            throttle_drop,
+            // Held back, replacing older held back args
+            throttle_coalesce,
+            // Held back; start a timer for delay() and call fire()
+            throttle_schedule,
+            // Held back until the running timer fires
+            throttle_hold
+        };
+    private:
+        // Earliest time the next signal may be sent
+        clock::time_point _ready_at{};
+        clock::duration _delay{0};
+        bool _timer = false;
+        std::optional<Payload> _pending;
+
+        // Saturates instead of overflowing for huge intervals
+        static clock::time_point _after(clock::time_point now,
+                                        clock::duration interval) {
+            if (interval > clock::time_point::max() - now)
+                return clock::time_point::max();
+            return now + interval;
+        }
+
+    public:
+        action emit(const signal_policy& policy, clock::time_point now,
+                    const Payload& payload) {
+            if (!policy.coalesce_latest) {
+                // Not kept: drop mode has no trailing emission
+                if (now < _ready_at)
+                    return throttle_drop;
+                _ready_at = _after(now, policy.min_interval);
+                return throttle_send;
+            }
+
+            const bool replaced = _pending.has_value();
+            _pending = payload;
+            if (_timer)
+                return replaced ? throttle_coalesce : throttle_hold;
+
+            _timer = true;
+            _delay = std::max(_ready_at - now, clock::duration::zero());
+            return throttle_schedule;
+        }
+
+        // Timer delay for throttle_schedule and after fire()
+        [[nodiscard]] clock::duration delay() const {
+            return _delay;
+        }
+
+        // Called when the timer fires. Returns the held back args to send,
+        // if any. Afterwards the timer should be restarted for delay() if
+        // timer_running(), and the throttle can be discarded if idle().
+        std::optional<Payload> fire(const signal_policy& policy,
+                                    clock::time_point now) {
+            std::optional<Payload> ret;
+            ret.swap(_pending);
+            if (ret && policy.min_interval > clock::duration::zero()) {
+                // Idles out if nothing is emitted during the interval
+                _ready_at = _after(now, policy.min_interval);
+                _delay = policy.min_interval;
+            } else {
+                _timer = false;
+            }
+            return ret;
+        }
+
+        [[nodiscard]] bool timer_running() const {
+            return _timer;
+        }
+
+        // Nothing held back and no effect on the next emission
+        [[nodiscard]] bool idle(clock::time_point now) const {
+            return !_timer && !_pending && now >= _ready_at;
+        }
+    };
+}
+
+#endif //IPCGULL_SIGNAL_THROTTLE_H
@@ -0,0 +1,140 @@
+/*
+ * Copyright 2022 PixlOne
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <cmath>
+#include <tuple>
+#include <ipcgull/stats.h>
+
+using namespace ipcgull;
+
+std::chrono::nanoseconds histogram_snapshot::mean() const {
+    if (!count)
+        return std::chrono::nanoseconds::zero();
+    return total / count;
+}
+
+std::chrono::nanoseconds histogram_snapshot::percentile(double p) const {
+    if (!count)
+        return std::chrono::nanoseconds::zero();
+
+    const auto target = static_cast<uint64_t>(
+            std::ceil(static_cast<double>(count) * p / 100.0));
+    uint64_t seen = 0;
+    for (std::size_t i = 0; i < buckets.size(); ++i) {
+        seen += buckets[i];
+        if (seen >= target && seen > 0)
+            return std::chrono::nanoseconds(
+                    latency_histogram::bucket_floor(i));
+    }
+
+    return max;
+}
+
+void latency_histogram::record(std::chrono::nanoseconds duration) noexcept {
+    const auto ns = static_cast<uint64_t>(
+            std::max(duration.count(), static_cast<int64_t>(0)));
+    _buckets[bucket_index(ns)].fetch_add(1, std::memory_order_relaxed);
+    _count.fetch_add(1, std::memory_order_relaxed);
+    _total.fetch_add(ns, std::memory_order_relaxed);
+
+    auto prev_max = _max.load(std::memory_order_relaxed);
+    while (prev_max < ns &&
+           !_max.compare_exchange_weak(prev_max, ns,
+                                       std::memory_order_relaxed)) {}
+}
+
+histogram_snapshot latency_histogram::snapshot() const {
+    histogram_snapshot ret;
+    ret.buckets.resize(bucket_count);
+    for (std::size_t i = 0; i < bucket_count; ++i)
+        ret.buckets[i] = _buckets[i].load(std::memory_order_relaxed);
+    ret.count = _count.load(std::memory_order_relaxed);
+    ret.total = std::chrono::nanoseconds(
+            _total.load(std::memory_order_relaxed));
+    ret.max = std::chrono::nanoseconds(_max.load(std::memory_order_relaxed));
+
+    return ret;
+}
+
+void latency_histogram::reset() noexcept {
+    for (auto& x: _buckets)
+        x.store(0, std::memory_order_relaxed);
+    _count.store(0, std::memory_order_relaxed);
+    _total.store(0, std::memory_order_relaxed);
+    _max.store(0, std::memory_order_relaxed);
+}
+
+std::size_t latency_histogram::bucket_index(uint64_t ns) noexcept {
+    constexpr uint64_t sub_mask = (1 << sub_bucket_bits) - 1;
+    if (ns >> magnitude_count)
+        return bucket_count - 1;
+    if (ns <= sub_mask)
+        return ns;
+
+    const std::size_t magnitude = 63 - __builtin_clzll(ns);
+    const std::size_t group = magnitude - sub_bucket_bits + 1;
+    const auto sub = (ns >> (magnitude - sub_bucket_bits)) & sub_mask;
+
+    return (group << sub_bucket_bits) | sub;
+}
+
+uint64_t latency_histogram::bucket_floor(std::size_t index) noexcept {
+    constexpr uint64_t sub_mask = (1 << sub_bucket_bits) - 1;
+    const std::size_t group = index >> sub_bucket_bits;
+    const uint64_t sub = index & sub_mask;
+    if (!group)
+        return sub;
+
+    const std::size_t magnitude = group + sub_bucket_bits - 1;
+    return (uint64_t(1) << magnitude) | (sub << (magnitude - sub_bucket_bits));
+}
+
+latency_histogram& call_latency::operator[](dispatch_phase phase) {
+    return _phases[phase];
+}
+
+const latency_histogram& call_latency::operator[](
+        dispatch_phase phase) const {
+    return _phases[phase];
+}
+
+void call_latency::record(dispatch_phase phase,
+                          std::chrono::steady_clock::time_point& since)
+noexcept {
+    const auto now = std::chrono::steady_clock::now();
+    _phases[phase].record(now - since);
+    since = now;
+}
+
+call_latency::snapshot_type call_latency::snapshot() const {
+    snapshot_type ret;
+    for (std::size_t i = 0; i < phase_count; ++i)
+        ret[i] = _phases[i].snapshot();
+
+    return ret;
+}
+
+void call_latency::reset() noexcept {
+    for (auto& x: _phases)
+        x.reset();
+}
+
+bool latency_key::operator<(const latency_key& o) const {
+    return std::tie(kind, interface, member) <
+           std::tie(o.kind, o.interface, o.member);
+}
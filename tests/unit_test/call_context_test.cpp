@@ -0,0 +1,151 @@
+/*
+ * Copyright 2022 PixlOne
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#include <thread>
+#include <ipcgull/call_context.h>
+#include <ipcgull/exception.h>
+#include <ipcgull/function.h>
+#include "check.h"
+
+using namespace ipcgull;
+using namespace std::chrono_literals;
+
+namespace {
+    typedef cancellation_token::clock clock;
+
+    void never_fires() {
+        const cancellation_token token;
+        CHECK(!token.cancelled());
+        CHECK(token.deadline() == clock::time_point::max());
+        token.throw_if_cancelled();
+    }
+
+    void deadline_expiry() {
+        const cancellation_token token(nullptr, clock::now() + 20ms);
+        CHECK(!token.cancelled());
+        token.throw_if_cancelled();
+
+        std::this_thread::sleep_until(token.deadline());
+        CHECK(token.cancelled());
+        CHECK_THROWS(token.throw_if_cancelled(), call_cancelled);
+
+        const cancellation_token expired(nullptr, clock::now() - 1ms);
+        CHECK(expired.cancelled());
+    }
+
+    // The backend raises the flag when the caller leaves the bus; copies
+    // handed to other threads see it too
+    void sender_disconnect() {
+        auto disconnected = std::make_shared<std::atomic_bool>(false);
+        const cancellation_token token(disconnected,
+                                       clock::time_point::max());
+        const call_context context("sender", token);
+        CHECK(!context.cancelled());
+
+        std::atomic_bool seen = false;
+        std::thread worker([copy = context.token(), &seen]() {
+            while (!copy.cancelled())
+                std::this_thread::yield();
+            seen = true;
+        });
+
+        *disconnected = true;
+        worker.join();
+        CHECK(seen);
+        CHECK(token.cancelled() && context.cancelled());
+        CHECK_THROWS(context.token().throw_if_cancelled(), call_cancelled);
+        CHECK(context.sender() == "sender");
+        CHECK(context.deadline() == clock::time_point::max());
+    }
+
+    // The context is only current on the handler's thread, for the
+    // handler's duration
+    void scope() {
+        CHECK(!call_context::current());
+
+        const call_context outer("outer", {});
+        const call_context inner("inner", {});
+        {
+            call_context::scope s(outer);
+            CHECK(call_context::current() == &outer);
+            {
+                call_context::scope nested(inner);
+                CHECK(call_context::current() == &inner);
+            }
+            CHECK(call_context::current() == &outer);
+
+            std::thread other([]() {
+                CHECK(!call_context::current());
+            });
+            other.join();
+        }
+        CHECK(!call_context::current());
+    }
+
+    // Handlers reach the token through call_context::current() and abort
+    // by throwing call_cancelled, which the backend reports as a timeout
+    void handler_abort() {
+        int runs = 0;
+        const function f(std::function<int()>([&runs]() {
+            const auto* context = call_context::current();
+            CHECK(context);
+            context->token().throw_if_cancelled();
+            return ++runs;
+        }), {}, {"runs"});
+
+        const call_context live("caller", {});
+        {
+            call_context::scope s(live);
+            CHECK(f.invoke(variant_tuple()));
+        }
+
+        const call_context expired(
+                "caller", cancellation_token(nullptr, clock::now() - 1ms));
+        {
+            call_context::scope s(expired);
+            CHECK_THROWS((void)f.invoke(variant_tuple()), call_cancelled);
+        }
+        CHECK(runs == 1);
+    }
+
+    // Deadlines and disconnect watching are opt-in
+    void function_options() {
+        function f(std::function<int()>([]() { return 0; }), {}, {"x"});
+        CHECK(function::default_timeout == 0ms);
+        CHECK(f.timeout() == 0ms);
+        CHECK(!f.cancel_on_disconnect());
+
+        f.set_timeout(5ms).set_cancel_on_disconnect();
+        CHECK(f.timeout() == 5ms);
+        CHECK(f.cancel_on_disconnect());
+
+        const function copy = f;
+        CHECK(copy.timeout() == 5ms && copy.cancel_on_disconnect());
+    }
+}
+
+int main() {
+    never_fires();
+    deadline_expiry();
+    sender_disconnect();
+    scope();
+    handler_abort();
+    function_options();
+    return 0;
+}
@@ -0,0 +1,49 @@
+/*
+ * Copyright 2022 PixlOne
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#ifndef IPCGULL_TEST_CHECK_H
+#define IPCGULL_TEST_CHECK_H
+
+#include <cstdlib>
+#include <iostream>
+
+// Unlike assert, still checked in release builds
+#define CHECK(x) do { \
+        if (!(x)) { \
+            std::cerr << __FILE__ << ":" << __LINE__ \
+                      << ": check failed: " #x << std::endl; \
+            std::exit(EXIT_FAILURE); \
+        } \
+    } while (false)
+
+#define CHECK_THROWS(x, exception) do { \
+        bool thrown = false; \
+        try { \
+            (void)(x); \
+        } catch (exception&) { \
+            thrown = true; \
+        } \
+        if (!thrown) { \
+            std::cerr << __FILE__ << ":" << __LINE__ \
+                      << ": " #x " did not throw " #exception << std::endl; \
+            std::exit(EXIT_FAILURE); \
+        } \
+    } while (false)
+
+#endif //IPCGULL_TEST_CHECK_H
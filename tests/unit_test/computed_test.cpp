@@ -0,0 +1,116 @@
+/*
+ * Copyright 2022 PixlOne
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+
+#include <ipcgull/property.h>
+#include <thread>
+#include "check.h"
+
+using namespace ipcgull;
+
+namespace {
+    constexpr int thread_count = 4;
+
+    void computed_cell_ttl() {
+        int calls = 0;
+        _computed_cell<int> cell([&calls]() { return ++calls; }, nullptr,
+                                 std::chrono::hours(1));
+        CHECK(cell.load() == 1);
+        CHECK(cell.load() == 1);
+        cell.invalidate();
+        CHECK(cell.load() == 2);
+
+        _computed_cell<int> uncached([&calls]() { return ++calls; },
+                                     nullptr, std::chrono::seconds(0));
+        CHECK(uncached.load() == 3);
+        CHECK(uncached.load() == 4);
+    }
+
+    void computed_cell_errors() {
+        bool fail = true;
+        _computed_cell<int> cell([&fail]() {
+            if (fail)
+                throw std::runtime_error("getter failed");
+            return 1;
+        }, nullptr, std::chrono::hours(1));
+        CHECK_THROWS(cell.load(), std::runtime_error);
+
+        // Errors are not cached
+        fail = false;
+        CHECK(cell.load() == 1);
+
+        CHECK_THROWS(cell.store(2), std::logic_error);
+        CHECK_THROWS(_computed_cell<int>(nullptr, nullptr,
+                                         std::chrono::seconds(0)),
+                     std::invalid_argument);
+    }
+
+    void computed_cell_store() {
+        int value = 1;
+        _computed_cell<int> cell([&value]() { return value; },
+                                 [&value](const int& x) { value = x; },
+                                 std::chrono::hours(1));
+        CHECK(cell.load() == 1);
+        cell.store(2);
+        CHECK(cell.load() == 2);
+    }
+
+    // At most one getter call at a time, even while the value is being
+    // invalidated under the readers
+    void computed_cell_single_flight() {
+        std::atomic<int> active = 0, max_active = 0;
+        _computed_cell<int> cell([&active, &max_active]() {
+            const int now = ++active;
+            int seen = max_active;
+            while (now > seen && !max_active.compare_exchange_weak(seen, now))
+                ;
+            std::this_thread::sleep_for(std::chrono::microseconds(200));
+            --active;
+            return 1;
+        }, nullptr, std::chrono::hours(1));
+        std::atomic_bool done = false;
+
+        std::thread invalidator([&cell, &done]() {
+            while (!done)
+                cell.invalidate();
+        });
+
+        std::vector<std::thread> readers;
+        for (int i = 0; i < thread_count; ++i) {
+            readers.emplace_back([&cell]() {
+                for (int j = 0; j < 500; ++j)
+                    CHECK(cell.load() == 1);
+            });
+        }
+        for (auto& x: readers)
+            x.join();
+        done = true;
+        invalidator.join();
+
+        CHECK(max_active == 1);
+    }
+}
+
+int main() {
+    computed_cell_ttl();
+    computed_cell_errors();
+    computed_cell_store();
+    computed_cell_single_flight();
+    return 0;
+}
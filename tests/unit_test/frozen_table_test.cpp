@@ -0,0 +1,83 @@
+/*
+ * Copyright 2022 PixlOne
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#include <ipcgull/table.h>
+#include "check.h"
+
+using namespace ipcgull;
+
+namespace {
+    void lookup() {
+        const frozen_table<int> table = {{"b", 2}, {"a", 1}, {"c", 3}};
+        CHECK(table.size() == 3);
+        CHECK(!table.empty());
+
+        CHECK(table.at("a") == 1);
+        CHECK(table.at(std::string("c")) == 3);
+        const char* key = "b";
+        CHECK(table.find(key)->second == 2);
+        CHECK(table.count("b") == 1);
+
+        CHECK(table.find("d") == table.end());
+        CHECK(table.find("") == table.end());
+        CHECK(table.find("bb") == table.end());
+        CHECK(table.count("d") == 0);
+        CHECK_THROWS(table.at("d"), std::out_of_range);
+    }
+
+    // Iterates in key order, like std::map
+    void order() {
+        const frozen_table<int> table = {{"z", 0}, {"m", 1}, {"a", 2},
+                                         {"ab", 3}};
+        std::vector<std::string> keys;
+        for (auto& x: table)
+            keys.push_back(x.first);
+        CHECK((keys == std::vector<std::string>{"a", "ab", "m", "z"}));
+    }
+
+    void duplicates() {
+        const frozen_table<int> table = {{"a", 1}, {"a", 2}};
+        CHECK(table.size() == 1);
+        CHECK(table.at("a") == 1);
+    }
+
+    void mutable_values() {
+        frozen_table<int> table(std::map<std::string, int>{{"a", 1}});
+        table.at("a") = 5;
+        table.find("a")->second += 1;
+        CHECK(table.at("a") == 6);
+    }
+
+    void empty() {
+        const frozen_table<int> table;
+        CHECK(table.empty());
+        CHECK(table.size() == 0);
+        CHECK(table.begin() == table.end());
+        CHECK(table.find("a") == table.end());
+    }
+}
+
+int main() {
+    lookup();
+    order();
+    duplicates();
+    mutable_values();
+    empty();
+    return 0;
+}
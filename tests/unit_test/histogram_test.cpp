@@ -0,0 +1,133 @@
+/*
+ * Copyright 2022 PixlOne
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#include <random>
+#include <thread>
+#include <ipcgull/stats.h>
+#include "check.h"
+
+using namespace ipcgull;
+using std::chrono::nanoseconds;
+
+namespace {
+    void buckets() {
+        typedef latency_histogram h;
+        for (uint64_t ns = 0; ns < 4; ++ns)
+            CHECK(h::bucket_index(ns) == ns && h::bucket_floor(ns) == ns);
+
+        for (std::size_t i = 0; i < h::bucket_count; ++i)
+            CHECK(h::bucket_index(h::bucket_floor(i)) == i);
+
+        // Buckets are ordered and the floor is within 25% of the value
+        std::mt19937_64 rng(1);
+        std::size_t last = 0;
+        for (uint64_t ns = 1; ns < (uint64_t(1) << h::magnitude_count);
+             ns += 1 + ns / 7 + rng() % 3) {
+            const auto index = h::bucket_index(ns);
+            const auto floor = h::bucket_floor(index);
+            CHECK(index >= last);
+            CHECK(floor <= ns);
+            CHECK(ns - floor <= floor / 4);
+            last = index;
+        }
+
+        // Huge durations are clamped into the last bucket
+        CHECK(h::bucket_index(uint64_t(1) << h::magnitude_count) ==
+              h::bucket_count - 1);
+        CHECK(h::bucket_index(UINT64_MAX) == h::bucket_count - 1);
+    }
+
+    void snapshots() {
+        latency_histogram h;
+        auto s = h.snapshot();
+        CHECK(s.count == 0);
+        CHECK(s.mean() == nanoseconds::zero());
+        CHECK(s.percentile(50) == nanoseconds::zero());
+
+        for (int i = 1; i <= 100; ++i)
+            h.record(nanoseconds(i * 1000));
+        // Negative durations count as 0
+        h.record(nanoseconds(-5));
+
+        s = h.snapshot();
+        CHECK(s.buckets.size() == latency_histogram::bucket_count);
+        CHECK(s.count == 101);
+        CHECK(s.total == nanoseconds(5050 * 1000));
+        CHECK(s.max == nanoseconds(100000));
+        CHECK(s.buckets[0] == 1);
+        CHECK(s.mean() == nanoseconds(5050 * 1000 / 101));
+
+        CHECK(s.percentile(0) == nanoseconds::zero());
+        const auto p50 = s.percentile(50).count();
+        CHECK(p50 <= 50000 && p50 >= 50000 * 3 / 4);
+        const auto p100 = s.percentile(100).count();
+        CHECK(p100 <= 100000 && p100 >= 100000 * 3 / 4);
+
+        h.reset();
+        s = h.snapshot();
+        CHECK(s.count == 0 && s.max == nanoseconds::zero());
+        for (auto x: s.buckets)
+            CHECK(x == 0);
+    }
+
+    // Recording is wait-free and loses nothing under contention
+    void concurrent() {
+        constexpr int threads = 4, records = 50000;
+        latency_histogram h;
+        std::vector<std::thread> writers;
+        for (int i = 0; i < threads; ++i) {
+            writers.emplace_back([&h, i]() {
+                for (int j = 0; j < records; ++j)
+                    h.record(nanoseconds(i * records + j));
+            });
+        }
+        for (auto& x: writers)
+            x.join();
+
+        const auto s = h.snapshot();
+        CHECK(s.count == threads * records);
+        CHECK(s.max == nanoseconds(threads * records - 1));
+        uint64_t total = 0;
+        for (auto x: s.buckets)
+            total += x;
+        CHECK(total == s.count);
+    }
+
+    void phases() {
+        call_latency latency;
+        auto since = std::chrono::steady_clock::now();
+        latency.record(phase_decode, since);
+        latency.record(phase_handler, since);
+        const auto s = latency.snapshot();
+        CHECK(s[phase_decode].count == 1);
+        CHECK(s[phase_handler].count == 1);
+        CHECK(s[phase_reply].count == 0);
+
+        latency.reset();
+        CHECK(latency.snapshot()[phase_decode].count == 0);
+    }
+}
+
+int main() {
+    buckets();
+    snapshots();
+    concurrent();
+    phases();
+    return 0;
+}
@@ -0,0 +1,109 @@
+/*
+ * Copyright 2022 PixlOne
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+
+#include <ipcgull/function.h>
+#include "check.h"
+
+using namespace ipcgull;
+
+namespace {
+    std::tuple<int, std::string> split(const std::string& s) {
+        return {static_cast<int>(s.size()), s.substr(0, 1)};
+    }
+
+    struct counter {
+        int count = 0;
+
+        void bump(int by) {
+            count += by;
+        }
+
+        [[nodiscard]] int get() const {
+            return count;
+        }
+    };
+
+    variant_tuple args(std::vector<variant> x) {
+        return variant_tuple(std::move(x));
+    }
+
+    int first_int(const variant_tuple& x) {
+        const std::vector<variant>& items = x;
+        CHECK(items.size() >= 1);
+        return from_variant<int>(items[0]);
+    }
+
+    void tuple_returns() {
+        const function f(split, {"s"}, {"length", "first"});
+        CHECK(f.return_types().size() == 2);
+        const auto r = f.invoke(args({std::string("hello")}));
+        CHECK(r);
+        const std::vector<variant>& items = *r;
+        CHECK(items.size() == 2);
+        CHECK(from_variant<int>(items[0]) == 5);
+        CHECK(from_variant<std::string>(items[1]) == "h");
+    }
+
+    void members() {
+        counter c;
+        const function bump(&c, &counter::bump, {"by"});
+        const function get(&c, &counter::get, {}, {"count"});
+        CHECK(bump.invoke(args({2})));
+        CHECK(bump.invoke(args({3})));
+        CHECK(c.count == 5);
+        CHECK(first_int(*get.invoke(args({}))) == 5);
+    }
+
+    // Copies and moves keep the target, whether stored inline or not
+    void copies() {
+        const std::string captured(100, 'x');
+        const function f(std::function<std::string(int)>(
+                [captured](int n) { return captured.substr(0, n); }),
+                         {"n"}, {"s"});
+
+        function copy = f;
+        function moved = std::move(copy);
+        copy = moved;
+        const std::array<const function*, 3> all = {&f, &copy, &moved};
+        for (auto* x: all) {
+            const auto r = x->invoke(args({3}));
+            CHECK(r);
+            const std::vector<variant>& items = *r;
+            CHECK(from_variant<std::string>(items[0]) == "xxx");
+        }
+
+        auto big = [captured, pad = std::array<char, 64>()](int n) {
+            return static_cast<int>(captured.size()) + n + pad[0];
+        };
+        static_assert(sizeof(big) > _invoker::buffer_size);
+        const auto invoker = _invoker::make<int, int>(big);
+        auto invoker_copy = invoker;
+        const auto invoker_moved = std::move(invoker_copy);
+        CHECK(first_int(*invoker(args({1}))) == 101);
+        CHECK(first_int(*invoker_moved(args({2}))) == 102);
+    }
+}
+
+int main() {
+    tuple_returns();
+    members();
+    copies();
+    return 0;
+}
@@ -0,0 +1,83 @@
+/*
+ * Copyright 2022 PixlOne
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#include <ipcgull/property.h>
+#include "check.h"
+
+using namespace ipcgull;
+
+namespace {
+    // Observers run without the property locked, so they may use it
+    void reentrant() {
+        property<int> p(property_full_permissions, 0);
+        std::vector<int> seen;
+        auto sub = p.subscribe([&p, &seen](const int& value) {
+            seen.push_back(value);
+            CHECK(static_cast<int>(p) == value);
+            if (value == 1)
+                p = 2;
+        });
+
+        p = 1;
+        CHECK((seen == std::vector<int>{1, 2}));
+        CHECK(static_cast<int>(p) == 2);
+    }
+
+    void executors() {
+        property<int> p(property_full_permissions, 0);
+        std::vector<std::function<void()>> queued;
+        int seen = 0;
+        auto sub = p.subscribe([&seen](const int& value) { seen = value; },
+                               [&queued](std::function<void()> f) {
+                                   queued.push_back(std::move(f));
+                               });
+
+        p = 1;
+        p = 2;
+        CHECK(seen == 0 && queued.size() == 2);
+        // Each call got its own copy
+        queued[0]();
+        CHECK(seen == 1);
+        queued[1]();
+        CHECK(seen == 2);
+    }
+
+    void unsubscribe() {
+        property<int> p(property_full_permissions, 0);
+        int calls = 0;
+        auto sub = p.subscribe([&calls](const int&) { ++calls; });
+        p = 1;
+        sub.unsubscribe();
+        p = 2;
+        CHECK(calls == 1);
+
+        {
+            auto scoped = p.subscribe([&calls](const int&) { ++calls; });
+        }
+        p = 3;
+        CHECK(calls == 1);
+    }
+}
+
+int main() {
+    reentrant();
+    executors();
+    unsubscribe();
+    return 0;
+}
@@ -0,0 +1,119 @@
+/*
+ * Copyright 2022 PixlOne
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+
+#include <ipcgull/exception.h>
+#include <ipcgull/function.h>
+#include "check.h"
+
+using namespace ipcgull;
+
+namespace {
+    int add(int a, int b) {
+        return a + b;
+    }
+
+    result<int> checked_div(int a, int b) {
+        if (b == 0)
+            return call_error(error_invalid_args, "division by zero");
+        return a / b;
+    }
+
+    variant_tuple args(std::vector<variant> x) {
+        return variant_tuple(std::move(x));
+    }
+
+    int first_int(const variant_tuple& x) {
+        const std::vector<variant>& items = x;
+        CHECK(items.size() >= 1);
+        return from_variant<int>(items[0]);
+    }
+
+    void results() {
+        result<int> ok = 5;
+        CHECK(ok.has_value() && ok);
+        CHECK(*ok == 5 && ok.value() == 5);
+
+        result<int> failed = call_error(error_invalid_args, "bad");
+        CHECK(!failed);
+        CHECK(failed.error().code() == error_invalid_args);
+        CHECK(failed.error().message() == "bad");
+        CHECK(failed.error().name().empty());
+        CHECK_THROWS(failed.value(), std::invalid_argument);
+
+        result<void> done;
+        CHECK(done);
+        done.value();
+        result<void> denied = call_error(error_access_denied, "no");
+        CHECK_THROWS(denied.value(), permission_denied);
+
+        const call_error typed("com.example.Error.Busy", "busy");
+        CHECK(typed.name() == "com.example.Error.Busy");
+        CHECK(typed.code() == error_failed);
+        CHECK_THROWS(typed.raise(), std::runtime_error);
+
+        CHECK_THROWS(call_error(error_invalid_signature, "").raise(),
+                     std::bad_variant_access);
+        CHECK_THROWS(call_error(error_unknown_property, "").raise(),
+                     std::out_of_range);
+        CHECK_THROWS(call_error(error_timeout, "").raise(), call_cancelled);
+    }
+
+    void invoke() {
+        const function f(add, {"a", "b"}, {"sum"});
+        CHECK(f.arg_names().size() == 2);
+        CHECK(f.return_types().size() == 1);
+
+        auto r = f.invoke(args({3, 4}));
+        CHECK(r && first_int(*r) == 7);
+        CHECK(first_int(f(args({1, 1}))) == 2);
+
+        // Bad arguments are reported, not thrown
+        r = f.invoke(args({std::string("3"), 4}));
+        CHECK(!r && r.error().code() == error_invalid_signature);
+        r = f.invoke(args({3}));
+        CHECK(!r && r.error().code() == error_invalid_signature);
+        CHECK_THROWS(f(args({3})), std::bad_variant_access);
+    }
+
+    void handler_errors() {
+        const function f(checked_div, {"a", "b"}, {"quotient"});
+        auto r = f.invoke(args({6, 3}));
+        CHECK(r && first_int(*r) == 2);
+
+        r = f.invoke(args({1, 0}));
+        CHECK(!r && r.error().code() == error_invalid_args);
+        CHECK(r.error().message() == "division by zero");
+        CHECK_THROWS(f(args({1, 0})), std::invalid_argument);
+
+        // Exceptions from the handler itself still propagate
+        const function thrower(std::function<int()>([]() -> int {
+            throw std::logic_error("handler");
+        }), {}, {"x"});
+        CHECK_THROWS((void)thrower.invoke(args({})), std::logic_error);
+    }
+
+}
+
+int main() {
+    results();
+    invoke();
+    handler_errors();
+    return 0;
+}
@@ -0,0 +1,65 @@
+/*
+ * Copyright 2022 PixlOne
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+
+#include <ipcgull/property.h>
+#include <thread>
+#include "check.h"
+
+using namespace ipcgull;
+
+namespace {
+    struct triple {
+        uint64_t a, b, c;
+    };
+
+    constexpr int thread_count = 4;
+
+    // Readers never see a torn value, and values never go backwards
+    void seqlock_cell() {
+        _seqlock_cell<triple> cell({0, 0, 0});
+        std::atomic_bool done = false;
+
+        std::vector<std::thread> readers;
+        for (int i = 0; i < thread_count; ++i) {
+            readers.emplace_back([&cell, &done]() {
+                uint64_t last = 0;
+                while (!done) {
+                    const auto x = cell.load();
+                    CHECK(x.a == x.b && x.b == x.c);
+                    CHECK(x.a >= last);
+                    last = x.a;
+                }
+            });
+        }
+
+        for (uint64_t i = 1; i <= 100000; ++i)
+            cell.store({i, i, i});
+        done = true;
+        for (auto& x: readers)
+            x.join();
+
+        CHECK(cell.load().c == 100000);
+    }
+}
+
+int main() {
+    seqlock_cell();
+    return 0;
+}
@@ -0,0 +1,113 @@
+/*
+ * Copyright 2022 PixlOne
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#include <memory>
+#include <thread>
+#include <vector>
+#include <ipcgull/signal.h>
+#include "mpmc_ring.h"
+#include "check.h"
+
+using namespace ipcgull;
+
+namespace {
+    typedef mpmc_ring<std::unique_ptr<int>> ring;
+
+    // As server::set_signal_queue's overflow policies do
+    bool push(ring& queue, int value, signal_overflow overflow) {
+        auto x = std::make_unique<int>(value);
+        while (!queue.try_push(x)) {
+            if (overflow == overflow_drop_newest)
+                return false;
+            std::unique_ptr<int> oldest;
+            queue.try_pop(oldest);
+        }
+        return true;
+    }
+
+    std::vector<int> drain(ring& queue) {
+        std::vector<int> ret;
+        std::unique_ptr<int> x;
+        while (queue.try_pop(x))
+            ret.push_back(*x);
+        return ret;
+    }
+
+    void overflow() {
+        ring queue(3);
+        CHECK(queue.capacity() == 4);
+        CHECK(ring(1).capacity() == 2);
+
+        for (int i = 0; i < 6; ++i)
+            push(queue, i, overflow_drop_oldest);
+        CHECK((drain(queue) == std::vector<int>{2, 3, 4, 5}));
+
+        for (int i = 0; i < 6; ++i)
+            CHECK(push(queue, i, overflow_drop_newest) == (i < 4));
+        CHECK((drain(queue) == std::vector<int>{0, 1, 2, 3}));
+
+        // A failed push leaves the value in place
+        auto x = std::make_unique<int>(0);
+        for (int i = 0; i < 4; ++i)
+            push(queue, i, overflow_drop_newest);
+        CHECK(!queue.try_push(x) && x);
+    }
+
+    // Every value pushed is popped exactly once
+    void concurrent_ring() {
+        constexpr int producers = 3, values = 20000;
+        ring queue(64);
+        std::atomic<int> popped = 0;
+        std::atomic<int64_t> sum = 0;
+
+        std::vector<std::thread> threads;
+        for (int i = 0; i < producers; ++i) {
+            threads.emplace_back([&queue]() {
+                for (int j = 1; j <= values; ++j) {
+                    auto x = std::make_unique<int>(j);
+                    while (!queue.try_push(x))
+                        std::this_thread::yield();
+                }
+            });
+        }
+        for (int i = 0; i < 2; ++i) {
+            threads.emplace_back([&]() {
+                std::unique_ptr<int> x;
+                while (popped < producers * values) {
+                    if (queue.try_pop(x)) {
+                        sum += *x;
+                        ++popped;
+                    } else {
+                        std::this_thread::yield();
+                    }
+                }
+            });
+        }
+        for (auto& x: threads)
+            x.join();
+
+        CHECK(sum == int64_t(producers) * values * (values + 1) / 2);
+    }
+}
+
+int main() {
+    overflow();
+    concurrent_ring();
+    return 0;
+}
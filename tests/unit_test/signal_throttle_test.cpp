@@ -0,0 +1,139 @@
+/*
+ * Copyright 2022 PixlOne
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#include <cmath>
+#include <ipcgull/signal.h>
+#include "signal_throttle.h"
+#include "check.h"
+
+using namespace ipcgull;
+using namespace std::chrono_literals;
+
+namespace {
+    typedef signal_throttle<int> throttle;
+    typedef throttle::clock clock;
+
+    const auto test_signal = make_signal<int>({"value"});
+
+    void policies() {
+        CHECK(!test_signal.policy.throttled());
+        CHECK(test_signal.with_coalesce_latest().policy.throttled());
+        CHECK(test_signal.with_min_interval(1ms).policy.throttled());
+        CHECK(test_signal.with_overflow(overflow_drop_oldest).policy.overflow ==
+              overflow_drop_oldest);
+
+        CHECK(test_signal.with_max_rate(10).policy.min_interval == 100ms);
+        CHECK(test_signal.with_max_rate(1e12).policy.min_interval >=
+              clock::duration::zero());
+        // Slower than one per duration::max() clamps instead of overflowing
+        CHECK(test_signal.with_max_rate(1e-300).policy.min_interval ==
+              clock::duration::max());
+
+        CHECK_THROWS(test_signal.with_max_rate(0), std::invalid_argument);
+        CHECK_THROWS(test_signal.with_max_rate(-1), std::invalid_argument);
+        CHECK_THROWS(test_signal.with_max_rate(std::nan("")),
+                     std::invalid_argument);
+
+        // Typed signals keep their type through the builders
+        typed_signal<int> typed = test_signal.with_max_rate(5)
+                .with_coalesce_latest();
+        CHECK(typed.policy.coalesce_latest);
+        CHECK(typed.policy.min_interval == 200ms);
+    }
+
+    // min_interval alone drops signals that come too soon
+    void min_interval() {
+        signal_policy policy;
+        policy.min_interval = 10ms;
+        throttle t;
+        const auto start = clock::now();
+
+        CHECK(t.emit(policy, start, 1) == throttle::throttle_send);
+        CHECK(!t.idle(start));
+        CHECK(t.emit(policy, start + 5ms, 2) == throttle::throttle_drop);
+        CHECK(t.emit(policy, start + 10ms, 3) == throttle::throttle_send);
+        // The last emission of a burst is lost too: nothing is held back
+        CHECK(t.emit(policy, start + 15ms, 4) == throttle::throttle_drop);
+        CHECK(!t.timer_running());
+        CHECK(t.idle(start + 20ms));
+
+        // Huge intervals saturate
+        policy.min_interval = clock::duration::max();
+        throttle saturated;
+        CHECK(saturated.emit(policy, start, 1) == throttle::throttle_send);
+        CHECK(saturated.emit(policy, start + 1h, 2) ==
+              throttle::throttle_drop);
+    }
+
+    // coalesce_latest alone sends the latest args on the next iteration
+    void coalesce() {
+        signal_policy policy;
+        policy.coalesce_latest = true;
+        throttle t;
+        const auto now = clock::now();
+
+        CHECK(t.emit(policy, now, 1) == throttle::throttle_schedule);
+        CHECK(t.delay() == clock::duration::zero());
+        CHECK(t.emit(policy, now, 2) == throttle::throttle_coalesce);
+        CHECK(t.emit(policy, now, 3) == throttle::throttle_coalesce);
+
+        const auto sent = t.fire(policy, now);
+        CHECK(sent && *sent == 3);
+        CHECK(!t.timer_running());
+        CHECK(t.idle(now));
+    }
+
+    void coalesce_with_interval() {
+        signal_policy policy;
+        policy.coalesce_latest = true;
+        policy.min_interval = 10ms;
+        throttle t;
+        const auto start = clock::now();
+
+        CHECK(t.emit(policy, start, 1) == throttle::throttle_schedule);
+        auto sent = t.fire(policy, start);
+        CHECK(sent && *sent == 1);
+        // The timer keeps running for the interval
+        CHECK(t.timer_running());
+        CHECK(t.delay() == 10ms);
+
+        CHECK(t.emit(policy, start + 2ms, 2) == throttle::throttle_hold);
+        CHECK(t.emit(policy, start + 4ms, 3) == throttle::throttle_coalesce);
+        sent = t.fire(policy, start + 10ms);
+        CHECK(sent && *sent == 3);
+        CHECK(t.timer_running());
+
+        // Nothing emitted during the interval: the timer stops
+        CHECK(!t.fire(policy, start + 20ms));
+        CHECK(!t.timer_running());
+        CHECK(t.idle(start + 20ms));
+
+        // After a quiet period the next signal is scheduled right away
+        CHECK(t.emit(policy, start + 50ms, 4) == throttle::throttle_schedule);
+        CHECK(t.delay() == clock::duration::zero());
+    }
+}
+
+int main() {
+    policies();
+    min_interval();
+    coalesce();
+    coalesce_with_interval();
+    return 0;
+}
@@ -0,0 +1,73 @@
+/*
+ * Copyright 2022 PixlOne
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+
+#include <ipcgull/property.h>
+#include <thread>
+#include "check.h"
+
+using namespace ipcgull;
+
+namespace {
+    constexpr int thread_count = 4;
+
+    // Concurrent updates all land, readers see whole versions
+    void snapshot_cell() {
+        constexpr int updates = 2000;
+        _snapshot_cell<std::vector<int>> cell(
+                std::make_shared<const std::vector<int>>(2, 0));
+        std::atomic_bool done = false;
+
+        std::thread reader([&cell, &done]() {
+            while (!done) {
+                const auto x = cell.load();
+                CHECK(x->size() == 2 && (*x)[0] == (*x)[1]);
+            }
+        });
+
+        std::vector<std::thread> writers;
+        for (int i = 0; i < thread_count; ++i) {
+            writers.emplace_back([&cell]() {
+                for (int j = 0; j < updates; ++j) {
+                    cell.update([](std::vector<int>& x) {
+                        ++x[0];
+                        ++x[1];
+                    });
+                }
+            });
+        }
+        for (auto& x: writers)
+            x.join();
+        done = true;
+        reader.join();
+
+        CHECK((*cell.load())[0] == thread_count * updates);
+
+        // Readers keep the version they loaded
+        const auto old = cell.load();
+        cell.store(std::vector<int>{1});
+        CHECK(old->size() == 2);
+        CHECK(cell.load()->size() == 1);
+    }
+}
+
+int main() {
+    snapshot_cell();
+    return 0;
+}
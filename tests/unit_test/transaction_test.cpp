@@ -0,0 +1,150 @@
+/*
+ * Copyright 2022 PixlOne
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#include <thread>
+#include <ipcgull/interface.h>
+#include <ipcgull/node.h>
+#include <ipcgull/server.h>
+#include "check.h"
+
+using namespace ipcgull;
+
+namespace {
+    typedef std::map<std::string, int> int_map;
+
+    class test_interface : public interface {
+    public:
+        test_interface(const property<int>& a, const property<int>& b,
+                       const map_property<std::string, int>& m) :
+                interface("pizza.pixl.ipcgull.test.transaction", {}, {
+                        {"A", a},
+                        {"B", b},
+                        {"M", m}
+                }, {
+                        {"Tick", make_signal<int>({"value"})}
+                }) {
+        }
+    };
+
+    struct fixture {
+        property<int> a{property_readable, 0};
+        property<int> b{property_readable, 0};
+        map_property<std::string, int> m{property_readable};
+        std::shared_ptr<server> s = make_server(
+                "pizza.pixl.ipcgull.test", "/pizza/pixl/ipcgull_test",
+                IPCGULL_USER);
+        std::shared_ptr<node> root = node::make_root("transaction");
+        std::shared_ptr<test_interface> iface;
+
+        fixture() {
+            root->add_server(s);
+            iface = root->make_interface<test_interface>(a, b, m);
+        }
+    };
+
+    // read_properties() returns the values grouped by lock, not by name
+    std::map<std::string, variant> by_name(
+            const std::vector<interface::property_value>& values) {
+        std::map<std::string, variant> ret;
+        for (auto& x: values)
+            ret.emplace(*x.name, x.value);
+        return ret;
+    }
+
+    // Readers see every transaction whole, while the writer edits a map
+    // property and emits signals inside it (the GetAll path on a server)
+    void atomic_reads() {
+        constexpr int writes = 2000;
+        fixture f;
+        std::atomic_bool done = false;
+
+        std::thread reader([&f, &done]() {
+            int last = 0;
+            while (!done) {
+                auto values = by_name(f.iface->read_properties());
+                CHECK(values.size() == 3);
+                const int a = from_variant<int>(values["A"]);
+                const int b = from_variant<int>(values["B"]);
+                const auto m = from_variant<int_map>(values["M"]);
+                CHECK(a == b);
+                CHECK(m.empty() ? a == 0 : m.at("k") == a);
+                CHECK(a >= last);
+                last = a;
+            }
+        });
+
+        for (int i = 1; i <= writes; ++i) {
+            interface::transaction t(*f.iface);
+            f.a = i;
+            f.iface->emit_signal("Tick", i);
+            f.m.insert_or_assign("k", i);
+            f.iface->emit_signal("Tick", -i);
+            f.b = i;
+        }
+        done = true;
+        reader.join();
+
+        CHECK(f.iface->property_changed_at("B") ==
+              f.iface->properties_version());
+    }
+
+    void nested() {
+        fixture f;
+        {
+            interface::transaction outer(*f.iface);
+            {
+                // Joins outer instead of waiting for it
+                interface::transaction inner(*f.iface);
+                f.a = 1;
+            }
+            f.b = 1;
+            outer.commit();
+
+            // Committed: readers no longer wait
+            std::thread reader([&f]() {
+                auto values = by_name(f.iface->read_properties());
+                CHECK(from_variant<int>(values["A"]) == 1);
+                CHECK(from_variant<int>(values["B"]) == 1);
+            });
+            reader.join();
+        }
+        CHECK(f.iface->property_changed_at("A") <
+              f.iface->property_changed_at("B"));
+    }
+
+    void filtered() {
+        fixture f;
+        f.a = 5;
+        const auto values = f.iface->read_properties(
+                [](const std::string& name, const base_property&) {
+                    return name == "A";
+                });
+        CHECK(values.size() == 1);
+        CHECK(*values[0].name == "A");
+        CHECK(from_variant<int>(values[0].value) == 5);
+        CHECK(values[0].version <= f.iface->properties_version());
+    }
+}
+
+int main() {
+    atomic_reads();
+    nested();
+    filtered();
+    return 0;
+}